@@ -11,6 +11,7 @@
 #include <ew/shader.h>
 #include <ew/ewMath/vec3.h>
 #include <ew/procGen.h>
+#include <ew/transformBatch.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
@@ -20,20 +21,16 @@ const int SCREEN_HEIGHT = 720;
 
 int main() {
 
-	// creates 4 cubes and starts them at different positions
-	am::Transform transform1;
-	transform1.position = ew::Vec3(-0.5, 0.5, 0.0);
-	am::Transform transform2;
-	transform2.position = ew::Vec3(0.5, 0.5, 0.0);
-	am::Transform transform3;
-	transform3.position = ew::Vec3(-0.5, -0.5, 0.0);
-	am::Transform transform4;
-	transform4.position = ew::Vec3(0.5, -0.5, 0.0);
-
-	am::Transform cubes[4] = { transform1, transform2, transform3, transform4 };
-
 	const int NUM_CUBES = 4;
 
+	// creates 4 cubes and starts them at different positions
+	ew::TransformBatch cubes(NUM_CUBES);
+	cubes.setPosition(0, ew::Vec3(-0.5, 0.5, 0.0));
+	cubes.setPosition(1, ew::Vec3(0.5, 0.5, 0.0));
+	cubes.setPosition(2, ew::Vec3(-0.5, -0.5, 0.0));
+	cubes.setPosition(3, ew::Vec3(0.5, -0.5, 0.0));
+	ew::Mat4 cubeModels[NUM_CUBES];
+
 	printf("Initializing...");
 	if (!glfwInit()) {
 		printf("GLFW failed to init!");
@@ -81,8 +78,9 @@ int main() {
 		shader.use();
 
 		//Set model matrix uniform
+		cubes.computeModelMatrices(cubeModels);
 		for (int i = 0; i < NUM_CUBES; i++) {
-			shader.setMat4("_Model", cubes[i].getModelMatrix());
+			shader.setMat4("_Model", cubeModels[i]);
 
 			cubeMesh.draw();
 		}
@@ -96,9 +94,11 @@ int main() {
 			for (size_t i = 0; i < NUM_CUBES; i++) {
 				ImGui::PushID(i);
 				if (ImGui::CollapsingHeader("Transform")) {
-					ImGui::DragFloat3("Position", &cubes[i].position.x, 0.05f);
-					ImGui::DragFloat3("Rotation", &cubes[i].rotation.x, 1.0f);
-					ImGui::DragFloat3("Scale", &cubes[i].scale.x, 0.05f);
+					ew::Transform transform = cubes.getTransform(i);
+					ImGui::DragFloat3("Position", &transform.position.x, 0.05f);
+					ImGui::DragFloat3("Rotation", &transform.rotation.x, 1.0f);
+					ImGui::DragFloat3("Scale", &transform.scale.x, 0.05f);
+					cubes.setTransform(i, transform);
 				}
 				ImGui::PopID();
 			}
@@ -1,9 +1,9 @@
 #version 450
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
+layout(location = 3) in mat4 vModel; //Per instance model matrix
 
 out vec3 Normal;
-uniform mat4 _Model;
 uniform mat4 _View;
 uniform mat4 _Projection;
 uniform float _Width;
@@ -11,7 +11,7 @@ uniform float _Height;
 
 void main(){
 	Normal = vNormal;
-	gl_Position = _Projection * _View * _Model * vec4(vPos,1.0);
+	gl_Position = _Projection * _View * vModel * vec4(vPos,1.0);
 
 	//gl_Position.z*=-1.0;
 	gl_Position.x *= _Height / _Width;
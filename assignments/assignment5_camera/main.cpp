@@ -12,6 +12,8 @@
 #include <ew/shader.h>
 #include <ew/procGen.h>
 #include <ew/transform.h>
+#include <ew/transformBatch.h>
+#include <ew/instanceBuffer.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
@@ -22,7 +24,8 @@ const int SCREEN_WIDTH = 1080;
 const int SCREEN_HEIGHT = 720;
 
 const int NUM_CUBES = 4;
-ew::Transform cubeTransforms[NUM_CUBES];
+ew::TransformBatch cubeTransforms(NUM_CUBES);
+ew::Mat4 cubeModels[NUM_CUBES];
 
 int main() {
 	printf("Initializing...");
@@ -61,6 +64,7 @@ int main() {
 	
 	//Cube mesh
 	ew::Mesh cubeMesh(ew::createCube(0.5f));
+	ew::InstanceBuffer cubeInstances;
 
 	// camera
 	am::Camera camera;
@@ -77,9 +81,12 @@ int main() {
 	//Cube positions
 	for (size_t i = 0; i < NUM_CUBES; i++)
 	{
-		cubeTransforms[i].position.x = i % (NUM_CUBES / 2) - 0.5;
-		cubeTransforms[i].position.y = i / (NUM_CUBES / 2) - 0.5;
+		cubeTransforms.positionX[i] = i % (NUM_CUBES / 2) - 0.5;
+		cubeTransforms.positionY[i] = i / (NUM_CUBES / 2) - 0.5;
 	}
+	cubeTransforms.computeModelMatrices(cubeModels);
+	cubeInstances.load(cubeModels, NUM_CUBES);
+	cubeMesh.attachInstanceBuffer(cubeInstances);
 
 	float prevTime = 0;
 	while (!glfwWindowShouldClose(window)) {
@@ -101,15 +108,10 @@ int main() {
 		shader.setFloat("_Width", SCREEN_WIDTH);
 		shader.setMat4("_View", camera.ViewMatrix());
 		shader.setMat4("_Projection", camera.ProjectionMatrix());
-		//TODO: Set model matrix uniform
-		for (size_t i = 0; i < NUM_CUBES; i++)
-		{
-
-			//Construct model matrix
-
-			shader.setMat4("_Model", cubeTransforms[i].getModelMatrix());
-			cubeMesh.draw();
-		}
+		//Construct all model matrices at once, then draw every cube in a single call
+		cubeTransforms.computeModelMatrices(cubeModels);
+		cubeInstances.load(cubeModels, NUM_CUBES);
+		cubeMesh.drawInstanced(NUM_CUBES);
 
 		//Render UI
 		{
@@ -123,9 +125,11 @@ int main() {
 				{
 					ImGui::PushID(i);
 					if (ImGui::CollapsingHeader("Transform")) {
-						ImGui::DragFloat3("Position", &cubeTransforms[i].position.x, 0.05f);
-						ImGui::DragFloat3("Rotation", &cubeTransforms[i].rotation.x, 1.0f);
-						ImGui::DragFloat3("Scale", &cubeTransforms[i].scale.x, 0.5f);
+						ew::Transform transform = cubeTransforms.getTransform(i);
+						ImGui::DragFloat3("Position", &transform.position.x, 0.05f);
+						ImGui::DragFloat3("Rotation", &transform.rotation.x, 1.0f);
+						ImGui::DragFloat3("Scale", &transform.scale.x, 0.5f);
+						cubeTransforms.setTransform(i, transform);
 					}
 					ImGui::PopID();
 				}
@@ -11,6 +11,7 @@
 #include <ew/shader.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
+#include <ew/meshCache.h>
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
@@ -80,22 +81,33 @@ int main() {
 	ew::Shader shader("assets/vertexShader.vert", "assets/fragmentShader.frag");
 	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg",GL_REPEAT,GL_LINEAR);
 
+	//Generated meshes are reordered for the post transform vertex cache
+	ew::setOptimizeGeneratedMeshes(true);
+
 	//Create cube
 
 	ew::MeshData cubeMeshData = ew::createCube(1.0f);
 	ew::Mesh cubeMesh(cubeMeshData);
 
+	//Generated meshes are cached on disk, later runs map the files instead of regenerating
+	ew::MeshCache meshCache;
+
 	// create plane
-	ew::MeshData planeMeshData = am::createPlane(1, 1, 16);
-	ew::Mesh planeMesh(planeMeshData);
+	ew::Mesh planeMesh;
+	meshCache.load(&planeMesh, ew::MeshCache::makeKey("amPlane", { 1, 1, 16 }),
+		[]() { return am::createPlane(1, 1, 16); }, ew::VertexFormat::PACKED);
 
 	// Create cylinder
-	ew::MeshData cylinderMeshData = am::createCylinder(1, 0.5, 32);
-	ew::Mesh cylinderMesh(cylinderMeshData);
+	ew::Mesh cylinderMesh;
+	meshCache.load(&cylinderMesh, ew::MeshCache::makeKey("amCylinder", { 1, 0.5f, 32 }),
+		[]() { return am::createCylinder(1, 0.5, 32); }, ew::VertexFormat::PACKED);
 
 	//create sphere
-	ew::MeshData sphereMeshData = am::createSphere(0.5, 32);
-	ew::Mesh sphereMesh(sphereMeshData);
+	ew::Mesh sphereMesh;
+	meshCache.load(&sphereMesh, ew::MeshCache::makeKey("amSphere", { 0.5f, 32 }),
+		[]() { return am::createSphere(0.5, 32); }, ew::VertexFormat::PACKED);
+	printf("Mesh cache: %d hits, %d misses\n", meshCache.getHits(), meshCache.getMisses());
+	ew::printMeshMemoryReport();
 
 	//Initialize transforms
 	ew::Transform cubeTransform;
@@ -144,15 +156,15 @@ int main() {
 		cubeMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
 
 		//draw plane
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
+		shader.setMat4("_Model", planeTransform.getModelMatrix() * planeMesh.getPositionTransform());
 		planeMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
 
 		// draw cylinder
-		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
+		shader.setMat4("_Model", cylinderTransform.getModelMatrix() * cylinderMesh.getPositionTransform());
 		cylinderMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
 
 		// draw sphere
-		shader.setMat4("_Model", sphereTransform.getModelMatrix());
+		shader.setMat4("_Model", sphereTransform.getModelMatrix() * sphereMesh.getPositionTransform());
 		sphereMesh.draw((ew::DrawMode)appSettings.drawAsPoints);
 
 		//Render UI
@@ -162,6 +174,9 @@ int main() {
 			ImGui::NewFrame();
 
 			ImGui::Begin("Settings");
+			const ew::MeshMemoryStats& memory = ew::getMeshMemoryStats();
+			ImGui::Text("Mesh memory: %.1f KB vertices, %.1f KB indices (%.1f KB saved by 16 bit indices)",
+				memory.vertexBytes / 1024.0f, memory.indexBytes / 1024.0f, memory.indexBytesSaved / 1024.0f);
 			if (ImGui::CollapsingHeader("Camera")) {
 				ImGui::DragFloat3("Position", &camera.position.x, 0.1f);
 				ImGui::DragFloat3("Target", &camera.target.x, 0.1f);
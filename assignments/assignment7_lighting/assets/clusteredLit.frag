@@ -0,0 +1,80 @@
+#version 450
+out vec4 FragColor;
+
+in Surface{
+	vec2 UV; // per fragment interpolated UV
+	vec3 WorldPosition; // per fragment interpolated world position
+	vec3 WorldNormal; // per fragment interpolated world normal
+}fs_in;
+
+//Written by ew::ClusteredLights
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 color;
+	float pad;
+};
+layout(std430, binding = 1) readonly buffer PointLightBuffer{
+	PointLight _PointLights[];
+};
+layout(std430, binding = 2) readonly buffer LightClusterBuffer{
+	uvec2 _LightClusters[]; //Offset into _LightIndices, count
+};
+layout(std430, binding = 3) readonly buffer LightIndexBuffer{
+	uint _LightIndices[];
+};
+layout(std140) uniform ClusterData{
+	mat4 _View;
+	ivec4 _ClusterCounts;
+	vec2 _ScreenSize;
+	float _ClusterDepthScale;
+	float _ClusterDepthBias;
+};
+
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+layout(std140) uniform MaterialData{
+	float _Ambient;
+	float _Diffuse;
+	float _Specular;
+	float _Shininess;
+};
+uniform sampler2D _Texture;
+uniform bool _ShowClusterLoad; //Shades by light count instead
+
+uvec2 getCluster(){
+	float depth = -(_View * vec4(fs_in.WorldPosition,1.0)).z;
+	ivec3 cluster;
+	cluster.xy = ivec2(gl_FragCoord.xy / _ScreenSize * vec2(_ClusterCounts.xy));
+	cluster.z = int(floor(log(depth) * _ClusterDepthScale - _ClusterDepthBias));
+	cluster = clamp(cluster, ivec3(0), _ClusterCounts.xyz - 1);
+	return _LightClusters[(cluster.z * _ClusterCounts.y + cluster.y) * _ClusterCounts.x + cluster.x];
+}
+
+void main(){
+	uvec2 cluster = getCluster();
+	if (_ShowClusterLoad){
+		//Green to red over 0 to 64 lights
+		float load = clamp(float(cluster.y) / 64.0, 0.0, 1.0);
+		FragColor = vec4(load, 1.0 - load, 0.0, 1.0) * (cluster.y > 0 ? 1.0 : 0.2);
+		return;
+	}
+	vec3 normal = normalize(fs_in.WorldNormal);
+	vec3 viewAngle = normalize(_CameraPosition - fs_in.WorldPosition);
+	vec3 light = vec3(0,0,0);
+	for (uint i = 0; i < cluster.y; i++){
+		PointLight _Light = _PointLights[_LightIndices[cluster.x + i]];
+		vec3 toLight = _Light.position - fs_in.WorldPosition;
+		float distance = length(toLight);
+		//Smooth falloff that reaches zero at the radius
+		float falloff = clamp(1.0 - distance / _Light.radius, 0.0, 1.0);
+		falloff *= falloff;
+		vec3 lightAngle = toLight / max(distance, 0.0001);
+		vec3 halfVector = normalize(viewAngle + lightAngle);
+		light = light + falloff * (_Light.color * _Ambient + _Light.color * _Diffuse * max(dot(lightAngle,normal),0) + _Light.color * _Specular * pow(max(dot(halfVector,normal),0),_Shininess));
+	}
+	FragColor = texture(_Texture,fs_in.UV) * vec4(light,1);
+}
@@ -13,15 +13,20 @@ struct Light
 	vec3 position;
 	vec3 color;
 };
-uniform float _LightsAmount;
-uniform Light _Lights[4];
-
-uniform vec3 _CameraPosition;
-
-uniform float _Shininess;
-uniform float _Diffuse;
-uniform float _Specular;
-uniform float _Ambient;
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+layout(std140) uniform LightData{
+	Light _Lights[4];
+	int _LightsAmount;
+};
+layout(std140) uniform MaterialData{
+	float _Ambient;
+	float _Diffuse;
+	float _Specular;
+	float _Shininess;
+};
 uniform sampler2D _Texture;
 
 void main(){
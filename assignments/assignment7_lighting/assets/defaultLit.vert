@@ -9,12 +9,19 @@ out Surface{
 	vec3 WorldNormal;
 }vs_out;
 
+//Must match the depth pre-pass (depthOnly.vert) bit for bit for GL_EQUAL depth testing
+invariant gl_Position;
+
 uniform mat4 _Model;
-uniform mat4 _ViewProjection;
+uniform mat4 _NormalMatrix; //Inverse transpose of _Model
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
 
 void main(){
 	vs_out.UV = vUV;
 	vs_out.WorldPosition = vec3(_Model * vec4(vPos,1.0));
-	vs_out.WorldNormal = vec3(_Model * vec4(vNormal,0.0));
+	vs_out.WorldNormal = vec3(_NormalMatrix * vec4(vNormal,0.0));
 	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
 }
\ No newline at end of file
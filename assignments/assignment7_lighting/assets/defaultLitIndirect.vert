@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vUV;
+
+out Surface{
+	vec2 UV;
+	vec3 WorldPosition;
+	vec3 WorldNormal;
+}vs_out;
+
+//Must match the depth pre-pass (depthOnly.vert) bit for bit for GL_EQUAL depth testing
+invariant gl_Position;
+
+//Written by ew::DrawList, one entry per instance. Each command's instances start at its baseInstance
+struct DrawData{
+	mat4 model;
+	mat4 normalMatrix;
+};
+layout(std430, binding = 0) readonly buffer DrawDataBuffer{
+	DrawData _DrawData[];
+};
+
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+
+void main(){
+	DrawData drawData = _DrawData[gl_BaseInstanceARB + gl_InstanceID];
+	vs_out.UV = vUV;
+	vs_out.WorldPosition = vec3(drawData.model * vec4(vPos,1.0));
+	vs_out.WorldNormal = vec3(drawData.normalMatrix * vec4(vNormal,0.0));
+	gl_Position = _ViewProjection * drawData.model * vec4(vPos,1.0);
+}
@@ -0,0 +1,120 @@
+#version 450
+//Lighting pass of the deferred path, once per pixel no matter how much geometry overlapped it
+out vec4 FragColor;
+in vec2 UV;
+
+uniform sampler2D _GAlbedo;
+uniform sampler2D _GNormal;
+uniform sampler2D _GMaterial;
+uniform sampler2D _GDepth;
+uniform mat4 _InverseViewProjection;
+uniform bool _Clustered; //Clustered point lights instead of LightData
+uniform bool _ShowClusterLoad;
+
+struct Light
+{
+	vec3 position;
+	vec3 color;
+};
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+layout(std140) uniform LightData{
+	Light _Lights[4];
+	int _LightsAmount;
+};
+
+//Written by ew::ClusteredLights
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 color;
+	float pad;
+};
+layout(std430, binding = 1) readonly buffer PointLightBuffer{
+	PointLight _PointLights[];
+};
+layout(std430, binding = 2) readonly buffer LightClusterBuffer{
+	uvec2 _LightClusters[]; //Offset into _LightIndices, count
+};
+layout(std430, binding = 3) readonly buffer LightIndexBuffer{
+	uint _LightIndices[];
+};
+layout(std140) uniform ClusterData{
+	mat4 _View;
+	ivec4 _ClusterCounts;
+	vec2 _ScreenSize;
+	float _ClusterDepthScale;
+	float _ClusterDepthBias;
+};
+
+vec3 decodeOctahedral(vec2 e){
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0){
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return normalize(n);
+}
+
+uvec2 getCluster(vec3 worldPosition){
+	float depth = -(_View * vec4(worldPosition,1.0)).z;
+	ivec3 cluster;
+	cluster.xy = ivec2(gl_FragCoord.xy / _ScreenSize * vec2(_ClusterCounts.xy));
+	cluster.z = int(floor(log(depth) * _ClusterDepthScale - _ClusterDepthBias));
+	cluster = clamp(cluster, ivec3(0), _ClusterCounts.xyz - 1);
+	return _LightClusters[(cluster.z * _ClusterCounts.y + cluster.y) * _ClusterCounts.x + cluster.x];
+}
+
+void main(){
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(_GDepth, pixel, 0).r;
+	//Nothing was drawn here, keep the clear color
+	if (depth == 1.0)
+		discard;
+	//Depth is copied so forward passes drawn afterwards are occluded correctly
+	gl_FragDepth = depth;
+	vec4 clip = _InverseViewProjection * vec4(UV * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec3 worldPosition = clip.xyz / clip.w;
+	vec4 albedo = texelFetch(_GAlbedo, pixel, 0);
+	vec3 normal = decodeOctahedral(texelFetch(_GNormal, pixel, 0).xy);
+	vec4 material = texelFetch(_GMaterial, pixel, 0);
+	float ambient = material.x;
+	float diffuse = material.y;
+	float specular = material.z;
+	float shininess = exp2(material.w * 8.0);
+
+	vec3 viewAngle = normalize(_CameraPosition - worldPosition);
+	vec3 light = vec3(0,0,0);
+	if (_Clustered){
+		uvec2 cluster = getCluster(worldPosition);
+		if (_ShowClusterLoad){
+			//Green to red over 0 to 64 lights
+			float load = clamp(float(cluster.y) / 64.0, 0.0, 1.0);
+			FragColor = vec4(load, 1.0 - load, 0.0, 1.0) * (cluster.y > 0 ? 1.0 : 0.2);
+			return;
+		}
+		for (uint i = 0; i < cluster.y; i++){
+			PointLight _Light = _PointLights[_LightIndices[cluster.x + i]];
+			vec3 toLight = _Light.position - worldPosition;
+			float distance = length(toLight);
+			//Smooth falloff that reaches zero at the radius
+			float falloff = clamp(1.0 - distance / _Light.radius, 0.0, 1.0);
+			falloff *= falloff;
+			vec3 lightAngle = toLight / max(distance, 0.0001);
+			vec3 halfVector = normalize(viewAngle + lightAngle);
+			light = light + falloff * (_Light.color * ambient + _Light.color * diffuse * max(dot(lightAngle,normal),0) + _Light.color * specular * pow(max(dot(halfVector,normal),0),shininess));
+		}
+	}
+	else{
+		for (int i = 0; i < _LightsAmount; i++){
+			Light _Light = _Lights[i];
+			vec3 lightAngle = normalize(_Light.position - worldPosition);
+			vec3 halfVector = normalize(viewAngle + lightAngle);
+			light = light + (_Light.color * ambient + _Light.color * diffuse * max(dot(lightAngle,normal),0) + _Light.color * specular * pow(max(dot(halfVector,normal),0),shininess));
+		}
+	}
+	FragColor = albedo * vec4(light,1);
+}
@@ -0,0 +1,8 @@
+#version 450
+//Fullscreen triangle from gl_VertexID, drawn by ew::GBuffer::drawFullscreenTriangle
+out vec2 UV;
+
+void main(){
+	UV = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(UV * 2.0 - 1.0, 0.0, 1.0);
+}
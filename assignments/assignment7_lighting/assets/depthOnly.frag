@@ -0,0 +1,5 @@
+#version 450
+//Depth is written by fixed function, nothing to shade
+
+void main(){
+}
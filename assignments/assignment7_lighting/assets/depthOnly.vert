@@ -0,0 +1,16 @@
+#version 450
+//Depth pre-pass and shadow maps. Reads the position only stream, see ew::Mesh::drawPositions
+layout(location = 0) in vec3 vPos;
+
+uniform mat4 _Model;
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+
+//Same expression as defaultLit.vert, so GL_EQUAL passes afterwards
+invariant gl_Position;
+
+void main(){
+	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
+}
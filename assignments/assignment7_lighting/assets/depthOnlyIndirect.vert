@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+//Depth pre-pass for ew::DrawList::submitPositions
+layout(location = 0) in vec3 vPos;
+
+//Written by ew::DrawList, one entry per instance
+struct DrawData{
+	mat4 model;
+	mat4 normalMatrix;
+};
+layout(std430, binding = 0) readonly buffer DrawDataBuffer{
+	DrawData _DrawData[];
+};
+
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+
+//Same expression as defaultLitIndirect.vert, so GL_EQUAL passes afterwards
+invariant gl_Position;
+
+void main(){
+	gl_Position = _ViewProjection * _DrawData[gl_BaseInstanceARB + gl_InstanceID].model * vec4(vPos,1.0);
+}
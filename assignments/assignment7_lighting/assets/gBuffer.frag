@@ -0,0 +1,32 @@
+#version 450
+//Geometry pass of the deferred path. Layout matches ew::GBuffer
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec2 gNormal;
+layout(location = 2) out vec4 gMaterial;
+
+in Surface{
+	vec2 UV; // per fragment interpolated UV
+	vec3 WorldPosition; // per fragment interpolated world position
+	vec3 WorldNormal; // per fragment interpolated world normal
+}fs_in;
+
+layout(std140) uniform MaterialData{
+	float _Ambient;
+	float _Diffuse;
+	float _Specular;
+	float _Shininess;
+};
+uniform sampler2D _Texture;
+
+//Unit vector folded onto the octahedron |x| + |y| + |z| = 1 and flattened to [-1,1]^2
+vec2 encodeOctahedral(vec3 n){
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
+
+void main(){
+	gAlbedo = texture(_Texture,fs_in.UV);
+	gNormal = encodeOctahedral(normalize(fs_in.WorldNormal));
+	gMaterial = vec4(_Ambient, _Diffuse, _Specular, log2(_Shininess) / 8.0);
+}
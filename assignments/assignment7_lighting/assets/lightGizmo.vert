@@ -0,0 +1,38 @@
+#version 450
+layout(location = 0) in vec3 vPos;
+
+out vec3 Color;
+
+//Instance i is light i, read from the same buffers the lit shaders use, so nothing is uploaded per gizmo
+struct Light
+{
+	vec3 position;
+	vec3 color;
+};
+layout(std140) uniform LightData{
+	Light _Lights[4];
+	int _LightsAmount;
+};
+//Written by ew::ClusteredLights
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 color;
+	float pad;
+};
+layout(std430, binding = 1) readonly buffer PointLightBuffer{
+	PointLight _PointLights[];
+};
+layout(std140) uniform FrameData{
+	mat4 _ViewProjection;
+	vec3 _CameraPosition;
+};
+uniform bool _Clustered; //Instances come from _PointLights instead of _Lights
+uniform float _Scale;
+
+void main(){
+	vec3 position = _Clustered ? _PointLights[gl_InstanceID].position : _Lights[gl_InstanceID].position;
+	Color = _Clustered ? _PointLights[gl_InstanceID].color : _Lights[gl_InstanceID].color;
+	gl_Position = _ViewProjection * vec4(position + vPos * _Scale, 1.0);
+}
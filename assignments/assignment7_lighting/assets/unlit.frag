@@ -1,8 +0,0 @@
-#version 450
-out vec4 FragColor;
-
-uniform vec3 _Color;
-
-void main(){
-	FragColor = vec4(_Color,1.0);
-}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <string>
+#include <vector>
+#include <stdlib.h>
 
 #include <ew/external/glad.h>
 #include <ew/ewMath/ewMath.h>
@@ -15,6 +17,17 @@
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
+#include <ew/uniformBuffer.h>
+#include <ew/uniformBlocks.h>
+#include <ew/geometryPool.h>
+#include <ew/drawList.h>
+#include <ew/renderQueue.h>
+#include <ew/frustum.h>
+#include <ew/meshLOD.h>
+#include <ew/clusteredLights.h>
+#include <ew/gpuTimer.h>
+#include <ew/gBuffer.h>
+#include <ew/occlusionCuller.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void resetCamera(ew::Camera& camera, ew::CameraController& cameraController);
@@ -74,8 +87,26 @@ int main() {
 	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
 	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg",GL_REPEAT,GL_LINEAR);
 
-	ew::Shader lightShader("assets/unlit.vert", "assets/unlit.frag");
-	const int MAX_LIGHTS = 4;
+	//Light gizmos, one instance per light read from the light buffers
+	ew::Shader lightShader("assets/lightGizmo.vert", "assets/lightGizmo.frag");
+	bool showLightGizmos = true;
+	//Same lighting, but model matrices come from the DrawList's storage buffer
+	ew::Shader indirectShader("assets/defaultLitIndirect.vert", "assets/defaultLit.frag");
+	bool useIndirect = false;
+	//Clustered forward lighting of many point lights, instead of the 4 lights above
+	ew::Shader clusteredShader("assets/defaultLit.vert", "assets/clusteredLit.frag");
+	ew::Shader clusteredIndirectShader("assets/defaultLitIndirect.vert", "assets/clusteredLit.frag");
+	bool useClustered = false;
+	//Deferred shading: the shapes write a G-buffer, then one fullscreen pass lights each pixel once
+	ew::Shader gBufferShader("assets/defaultLit.vert", "assets/gBuffer.frag");
+	ew::Shader gBufferIndirectShader("assets/defaultLitIndirect.vert", "assets/gBuffer.frag");
+	ew::Shader deferredShader("assets/deferredLit.vert", "assets/deferredLit.frag");
+	bool useDeferred = false;
+	//Depth pre-pass: lay down depth from positions alone, then shade with GL_EQUAL so each pixel is shaded once
+	ew::Shader depthShader("assets/depthOnly.vert", "assets/depthOnly.frag");
+	ew::Shader depthIndirectShader("assets/depthOnlyIndirect.vert", "assets/depthOnly.frag");
+	bool useDepthPrepass = false;
+	const int MAX_LIGHTS = ew::LightData::MAX_LIGHTS;
 	int lightsAmount = 4;
 	Light light0;
 	Light light1;
@@ -100,26 +131,131 @@ int main() {
 	lights[2] = light2;
 	lights[3] = light3;
 
+	//Clustered lights orbit random anchors scattered over a square of side clusteredLightArea
+	const int MAX_CLUSTERED_LIGHTS = 4096;
+	int clusteredLightCount = 1024;
+	float clusteredLightRadius = 2.0f;
+	float clusteredLightArea = 40.0f;
+	bool showClusterLoad = false;
+	std::vector<ew::Vec3> lightAnchors(MAX_CLUSTERED_LIGHTS);
+	std::vector<ew::Vec3> lightColors(MAX_CLUSTERED_LIGHTS);
+	std::vector<float> lightPhases(MAX_CLUSTERED_LIGHTS);
+	srand(1);
+	for (int i = 0; i < MAX_CLUSTERED_LIGHTS; i++) {
+		lightAnchors[i] = ew::Vec3(rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX * 2.0f - 0.5f, rand() / (float)RAND_MAX - 0.5f);
+		lightColors[i] = ew::Vec3(rand() / (float)RAND_MAX, rand() / (float)RAND_MAX, rand() / (float)RAND_MAX);
+		lightPhases[i] = rand() / (float)RAND_MAX * 6.2832f;
+	}
+	std::vector<ew::PointLight> pointLights;
+	ew::ClusteredLights clusteredLights;
+	float clusterAssignTime = 0.0f;
+
 	Material material;
 	material.shininess = 8.0;
 	material.ambientK = 0.5;
 	material.diffuseK = 0.0;
 	material.specular = 1.0;
 
-	//Create cube
-	ew::Mesh cubeMesh(ew::createCube(1.0f));
-	ew::Mesh planeMesh(ew::createPlane(5.0f, 5.0f, 10));
-	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
-	ew::Mesh cylinderMesh(ew::createCylinder(0.5f, 1.0f, 32));
-
-	//Initialize transforms
-	ew::Transform cubeTransform;
-	ew::Transform planeTransform;
-	ew::Transform sphereTransform;
-	ew::Transform cylinderTransform;
-	planeTransform.position = ew::Vec3(0, -1.0, 0);
-	sphereTransform.position = ew::Vec3(-1.5f, 0.0f, 0.0f);
-	cylinderTransform.position = ew::Vec3(1.5f, 0.0f, 0.0f);
+	//All meshes share one VAO/VBO/EBO, plus a position only stream for the depth pre-pass
+	ew::GeometryPool geometryPool(65536, 65536 * 3, true);
+	//The cube and planes keep their CPU copies, they double as occluders
+	ew::MeshData cubeData = ew::createCube(1.0f);
+	ew::MeshData planeData = ew::createPlane(5.0f, 5.0f, 10);
+	ew::Mesh cubeMesh(&geometryPool, cubeData);
+	ew::Mesh planeMesh(&geometryPool, planeData);
+	//Spheres are drawn from a 64/32/16/8 chain picked by their size on screen
+	ew::MeshLOD sphereLOD([](int subdivisions) { return ew::createSphere(0.5f, subdivisions); }, { 64, 32, 16, 8 }, &geometryPool);
+	int sphereLevel = -1;
+	ew::Mesh cylinderMesh(&geometryPool, ew::createCylinder(0.5f, 1.0f, 32));
+	//Replaces the plane in clustered mode so there is room to spread the lights out
+	ew::MeshData groundData = ew::createPlane(64.0f, 64.0f, 64);
+	ew::Mesh groundMesh(&geometryPool, groundData);
+
+	//Initialize transforms. Model matrices are cached, so static objects cost no matrix math per frame
+	ew::CachedTransform cubeTransform;
+	ew::CachedTransform planeTransform;
+	ew::CachedTransform sphereTransform;
+	ew::CachedTransform cylinderTransform;
+	planeTransform.setPosition(ew::Vec3(0, -1.0, 0));
+	sphereTransform.setPosition(ew::Vec3(-1.5f, 0.0f, 0.0f));
+	cylinderTransform.setPosition(ew::Vec3(1.5f, 0.0f, 0.0f));
+
+	const int NUM_SHAPES = 4;
+	const ew::Mesh* meshes[NUM_SHAPES] = { &cubeMesh, &planeMesh, &sphereLOD.getLevel(0), &cylinderMesh };
+	const ew::CachedTransform* transforms[NUM_SHAPES] = { &cubeTransform, &planeTransform, &sphereTransform, &cylinderTransform };
+
+	//Camera, light and material data live in uniform buffers shared by both programs
+	ew::UniformBuffer<ew::FrameData> frameBuffer(ew::FRAME_BLOCK_BINDING);
+	ew::UniformBuffer<ew::LightData> lightBuffer(ew::LIGHT_BLOCK_BINDING);
+	ew::UniformBuffer<ew::MaterialData> materialBuffer(ew::MATERIAL_BLOCK_BINDING);
+	shader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	shader.bindUniformBlock("LightData", ew::LIGHT_BLOCK_BINDING);
+	shader.bindUniformBlock("MaterialData", ew::MATERIAL_BLOCK_BINDING);
+	lightShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	lightShader.bindUniformBlock("LightData", ew::LIGHT_BLOCK_BINDING);
+	indirectShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	indirectShader.bindUniformBlock("LightData", ew::LIGHT_BLOCK_BINDING);
+	indirectShader.bindUniformBlock("MaterialData", ew::MATERIAL_BLOCK_BINDING);
+	for (const ew::Shader* litShader : { &clusteredShader, &clusteredIndirectShader }) {
+		litShader->bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+		litShader->bindUniformBlock("MaterialData", ew::MATERIAL_BLOCK_BINDING);
+		litShader->bindUniformBlock("ClusterData", ew::CLUSTER_BLOCK_BINDING);
+	}
+	gBufferShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	gBufferShader.bindUniformBlock("MaterialData", ew::MATERIAL_BLOCK_BINDING);
+	gBufferIndirectShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	gBufferIndirectShader.bindUniformBlock("MaterialData", ew::MATERIAL_BLOCK_BINDING);
+	deferredShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	deferredShader.bindUniformBlock("LightData", ew::LIGHT_BLOCK_BINDING);
+	deferredShader.bindUniformBlock("ClusterData", ew::CLUSTER_BLOCK_BINDING);
+	depthShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+	depthIndirectShader.bindUniformBlock("FrameData", ew::FRAME_BLOCK_BINDING);
+
+	//Resolve uniforms once so the render loop does no name lookups
+	const ew::UniformId lightClusteredId = lightShader.getUniformId("_Clustered");
+	const ew::UniformId lightScaleId = lightShader.getUniformId("_Scale");
+	//Programs that draw the shapes. [forward, clustered forward, deferred geometry][direct, indirect]
+	struct ShapeProgram {
+		ew::Shader* shader;
+		ew::UniformId textureId;
+		ew::UniformId showClusterLoadId;
+	};
+	auto makeShapeProgram = [](ew::Shader* shapeShader) {
+		ShapeProgram program;
+		program.shader = shapeShader;
+		program.textureId = shapeShader->getUniformId("_Texture");
+		program.showClusterLoadId = shapeShader->getUniformId("_ShowClusterLoad");
+		return program;
+	};
+	const ShapeProgram shapePrograms[3][2] = {
+		{ makeShapeProgram(&shader), makeShapeProgram(&indirectShader) },
+		{ makeShapeProgram(&clusteredShader), makeShapeProgram(&clusteredIndirectShader) },
+		{ makeShapeProgram(&gBufferShader), makeShapeProgram(&gBufferIndirectShader) }
+	};
+	const ew::UniformId gAlbedoId = deferredShader.getUniformId("_GAlbedo");
+	const ew::UniformId gNormalId = deferredShader.getUniformId("_GNormal");
+	const ew::UniformId gMaterialId = deferredShader.getUniformId("_GMaterial");
+	const ew::UniformId gDepthId = deferredShader.getUniformId("_GDepth");
+	const ew::UniformId inverseViewProjectionId = deferredShader.getUniformId("_InverseViewProjection");
+	const ew::UniformId deferredClusteredId = deferredShader.getUniformId("_Clustered");
+	const ew::UniformId deferredLoadId = deferredShader.getUniformId("_ShowClusterLoad");
+	const ew::UniformId depthModelId = depthShader.getUniformId("_Model");
+
+	ew::GBuffer gBuffer(SCREEN_WIDTH, SCREEN_HEIGHT);
+	//One timer per path, so switching never mixes their measurements
+	ew::GpuTimer forwardTimer;
+	ew::GpuTimer deferredTimer;
+	ew::GpuTimer gizmoTimer;
+
+	ew::DrawList drawList;
+	ew::RenderQueue renderQueue;
+	ew::BoundsBatch shapeBounds;
+	std::vector<unsigned int> visibleShapes;
+	//Shapes that pass the frustum are tested against the cube and plane rasterized on the CPU
+	ew::OcclusionCuller occlusionCuller;
+	std::vector<unsigned int> frustumVisibleShapes;
+	bool useOcclusionCulling = true;
+	float occlusionTime = 0.0f;
 
 	resetCamera(camera,cameraController);
 
@@ -138,50 +274,171 @@ int main() {
 		glClearColor(bgColor.x, bgColor.y,bgColor.z,1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		shader.use();
-		glBindTexture(GL_TEXTURE_2D, brickTexture);
-		shader.setInt("_Texture", 0);
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		//Upload per frame data, one glBufferSubData per block
+		ew::FrameData frameData;
+		frameData.viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+		frameData.cameraPosition = camera.position;
+		frameBuffer.update(frameData);
 
+		ew::LightData lightData;
+		lightData.count = lightsAmount;
 		for (int i = 0; i < lightsAmount; i++) {
-			shader.setVec3("_Lights[" + std::to_string(i) + "].color", lights[i].color);
-			shader.setVec3("_Lights[" + std::to_string(i) + "].position", lights[i].position);
+			lightData.lights[i].position = lights[i].position;
+			lightData.lights[i].color = lights[i].color;
+		}
+		lightBuffer.update(lightData);
+
+		ew::MaterialData materialData;
+		materialData.ambientK = material.ambientK;
+		materialData.diffuseK = material.diffuseK;
+		materialData.specular = material.specular;
+		materialData.shininess = material.shininess;
+		materialBuffer.update(materialData);
+
+		if (useClustered) {
+			pointLights.resize(clusteredLightCount);
+			for (int i = 0; i < clusteredLightCount; i++) {
+				float angle = time + lightPhases[i];
+				ew::Vec3 anchor = ew::Vec3(lightAnchors[i].x * clusteredLightArea, lightAnchors[i].y, lightAnchors[i].z * clusteredLightArea);
+				pointLights[i].position = anchor + ew::Vec3(cosf(angle), 0.0f, sinf(angle));
+				pointLights[i].radius = clusteredLightRadius;
+				pointLights[i].color = lightColors[i];
+			}
+			float assignStart = (float)glfwGetTime();
+			clusteredLights.update(pointLights, camera, SCREEN_WIDTH, SCREEN_HEIGHT);
+			clusterAssignTime = (float)glfwGetTime() - assignStart;
 		}
 
-		shader.setVec3("_CameraPosition", camera.position);
-		
-		shader.setFloat("_Shininess", material.shininess);
-		shader.setFloat("_Ambient", material.ambientK);
-		shader.setFloat("_Diffuse", material.diffuseK);
-		shader.setFloat("_Specular", material.specular);
-		shader.setFloat("_LightsAmount", lightsAmount);
-
-		//Draw shapes
-		shader.setMat4("_Model", cubeTransform.getModelMatrix());
-		cubeMesh.draw();
-
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
-		planeMesh.draw();
-
-		shader.setMat4("_Model", sphereTransform.getModelMatrix());
-		sphereMesh.draw();
+		//Pick the sphere's detail level from its projected size
+		ew::Bounds sphereBounds = ew::transformBounds(sphereLOD.getBounds(), sphereTransform.getModelMatrix());
+		sphereLOD.selectLevel(camera, (float)SCREEN_HEIGHT, sphereBounds.center, sphereBounds.radius, &sphereLevel);
+		meshes[2] = &sphereLOD.getLevel(sphereLevel);
+		meshes[1] = useClustered ? &groundMesh : &planeMesh;
+
+		//Frustum cull the shapes before building either draw path
+		ew::Frustum frustum = ew::extractFrustum(frameData.viewProjection);
+		shapeBounds.clear();
+		for (int i = 0; i < NUM_SHAPES; i++) {
+			shapeBounds.add(ew::transformBounds(meshes[i]->getBounds(), transforms[i]->getModelMatrix()));
+		}
+		visibleShapes.clear();
+		if (useOcclusionCulling) {
+			float occlusionStart = (float)glfwGetTime();
+			frustumVisibleShapes.clear();
+			ew::cullBoxes(frustum, shapeBounds, &frustumVisibleShapes);
+			occlusionCuller.beginFrame(frameData.viewProjection);
+			occlusionCuller.addOccluder(cubeData, cubeTransform.getModelMatrix());
+			occlusionCuller.addOccluder(useClustered ? groundData : planeData, planeTransform.getModelMatrix());
+			occlusionCuller.rasterize();
+			occlusionCuller.cull(shapeBounds, frustumVisibleShapes, &visibleShapes);
+			occlusionTime = (float)glfwGetTime() - occlusionStart;
+		}
+		else {
+			ew::cullBoxes(frustum, shapeBounds, &visibleShapes);
+		}
 
-		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
-		cylinderMesh.draw();
+		ew::GpuTimer& frameTimer = useDeferred ? deferredTimer : forwardTimer;
+		frameTimer.begin();
+		if (useDeferred) {
+			gBuffer.resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+			gBuffer.bind();
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+		if (useIndirect) {
+			drawList.clear();
+			for (unsigned int i : visibleShapes) {
+				drawList.add(*meshes[i], transforms[i]->getModelMatrix(), transforms[i]->getNormalMatrix());
+			}
+		}
+		if (useDepthPrepass) {
+			//Depth only, from the position stream
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			if (useIndirect) {
+				depthIndirectShader.use();
+				depthIndirectShader.resetLookupCount();
+				drawList.submitPositions(geometryPool);
+			}
+			else {
+				depthShader.use();
+				depthShader.resetLookupCount();
+				for (unsigned int i : visibleShapes) {
+					depthShader.setMat4(depthModelId, transforms[i]->getModelMatrix());
+					meshes[i]->drawPositions();
+				}
+			}
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			//Only the nearest surface passes, and depth is already final
+			glDepthFunc(GL_EQUAL);
+			glDepthMask(GL_FALSE);
+		}
+		const ShapeProgram& shapeProgram = shapePrograms[useDeferred ? 2 : (useClustered ? 1 : 0)][useIndirect ? 1 : 0];
+		ew::Shader& litShader = *shapeProgram.shader;
+		litShader.use();
+		litShader.resetLookupCount();
+		litShader.setInt(shapeProgram.textureId, 0);
+		litShader.setInt(shapeProgram.showClusterLoadId, showClusterLoad);
+		glBindTexture(GL_TEXTURE_2D, brickTexture);
+		if (useIndirect) {
+			//Every shape in a single glMultiDrawElementsIndirect, reusing the pre-pass upload
+			drawList.submit(geometryPool);
+		}
+		else {
+			//Draw shapes, sorted by state and then front to back
+			renderQueue.setMaxDepth(camera.farPlane);
+			renderQueue.beginFrame();
+			for (unsigned int i : visibleShapes) {
+				ew::DrawPacket packet;
+				packet.shader = &litShader;
+				packet.mesh = meshes[i];
+				packet.textures[0] = brickTexture;
+				packet.numTextures = 1;
+				packet.model = transforms[i]->getModelMatrix();
+				packet.normalMatrix = transforms[i]->getNormalMatrix();
+				packet.depth = ew::Magnitude(transforms[i]->getPosition() - camera.position);
+				renderQueue.add(packet);
+			}
+			renderQueue.submit();
+		}
+		if (useDepthPrepass) {
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_TRUE);
+		}
+		if (useDeferred) {
+			//Light every covered pixel once. The pass also copies the G-buffer depth so the gizmos below are occluded
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glDepthFunc(GL_ALWAYS);
+			deferredShader.use();
+			deferredShader.resetLookupCount();
+			gBuffer.bindTextures(0);
+			deferredShader.setInt(gAlbedoId, 0);
+			deferredShader.setInt(gNormalId, 1);
+			deferredShader.setInt(gMaterialId, 2);
+			deferredShader.setInt(gDepthId, 3);
+			deferredShader.setMat4(inverseViewProjectionId, ew::Inverse(frameData.viewProjection));
+			deferredShader.setInt(deferredClusteredId, useClustered);
+			deferredShader.setInt(deferredLoadId, showClusterLoad);
+			gBuffer.drawFullscreenTriangle();
+			glDepthFunc(GL_LESS);
+		}
+		frameTimer.end();
 
 		//Render point lights
 
 		lightShader.use();
-
-		lightShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
-		for (int i = 0; i < lightsAmount; i++) {
-			ew::Vec3 color = lights[i].color;
-			ew::Vec3 position = lights[i].position;
-			lightShader.setVec3("_Color", color);
-			lightShader.setMat4("_Model", ew::Translate(position) * ew::Scale(ew::Vec3(0.5, 0.5, 0.5)));
-			sphereMesh.draw();
+		lightShader.resetLookupCount();
+
+		//One instanced draw of the coarsest sphere for every light, positions and colors come from LightData or the PointLight buffer
+		gizmoTimer.begin();
+		if (showLightGizmos) {
+			lightShader.setInt(lightClusteredId, useClustered);
+			lightShader.setFloat(lightScaleId, useClustered ? 0.2f : 0.5f);
+			geometryPool.bindPositions();
+			geometryPool.drawInstanced(sphereLOD.getLevel(sphereLOD.getNumLevels() - 1).getAllocation(),
+				useClustered ? (int)clusteredLights.getLightCount() : lightsAmount);
 		}
-		
+		gizmoTimer.end();
+
 
 		//Render UI
 		{
@@ -190,6 +447,28 @@ int main() {
 			ImGui::NewFrame();
 
 			ImGui::Begin("Settings");
+			ImGui::Text("Uniform lookups this frame: %u", shader.getLookupCount() + lightShader.getLookupCount() + indirectShader.getLookupCount()
+				+ clusteredShader.getLookupCount() + clusteredIndirectShader.getLookupCount()
+				+ gBufferShader.getLookupCount() + gBufferIndirectShader.getLookupCount() + deferredShader.getLookupCount()
+				+ depthShader.getLookupCount() + depthIndirectShader.getLookupCount());
+			ImGui::Checkbox("Deferred shading", &useDeferred);
+			ImGui::Checkbox("Depth pre-pass", &useDepthPrepass);
+			ImGui::Text("Shading GPU time: forward %.2f ms, deferred %.2f ms", forwardTimer.getMilliseconds(), deferredTimer.getMilliseconds());
+			ImGui::Checkbox("Light gizmos", &showLightGizmos);
+			ImGui::Text("Gizmo GPU time: %.2f ms", gizmoTimer.getMilliseconds());
+			ImGui::Text("Visible shapes: %u / %d", (unsigned int)visibleShapes.size(), NUM_SHAPES);
+			ImGui::Checkbox("Occlusion culling", &useOcclusionCulling);
+			if (useOcclusionCulling) {
+				ImGui::Text("Occluded shapes: %u, CPU time: %.2f ms", (unsigned int)(frustumVisibleShapes.size() - visibleShapes.size()), occlusionTime * 1000.0f);
+			}
+			ImGui::Text("Sphere subdivisions: %d", sphereLOD.getSubdivisions(sphereLevel));
+			ImGui::Checkbox("Multi-draw indirect", &useIndirect);
+			if (!useIndirect) {
+				const ew::GLStateCache::Stats& stats = renderQueue.getStats();
+				ImGui::Text("State changes: %u, avoided: %u",
+					stats.programChanges + stats.textureChanges + stats.vertexArrayChanges,
+					stats.programChangesAvoided + stats.textureChangesAvoided + stats.vertexArrayChangesAvoided);
+			}
 			if (ImGui::CollapsingHeader("Camera")) {
 				ImGui::DragFloat3("Position", &camera.position.x, 0.1f);
 				ImGui::DragFloat3("Target", &camera.target.x, 0.1f);
@@ -216,7 +495,18 @@ int main() {
 				ImGui::DragFloat("SpecularK", &material.specular, 0.01f, 0.0f, 1.0f);
 				ImGui::DragFloat("Shininess", &material.shininess, 0.01f, 2.0f, 256.0f);
 			}
-			if (ImGui::CollapsingHeader("Lights")) {
+			ImGui::Checkbox("Clustered lights", &useClustered);
+			if (useClustered && ImGui::CollapsingHeader("Clustered Lights", ImGuiTreeNodeFlags_DefaultOpen)) {
+				ImGui::SliderInt("Count", &clusteredLightCount, 0, MAX_CLUSTERED_LIGHTS);
+				ImGui::SliderFloat("Radius", &clusteredLightRadius, 0.1f, 10.0f);
+				//Same count over a smaller area raises the lights per cluster, and with it the shading cost
+				ImGui::SliderFloat("Area", &clusteredLightArea, 4.0f, 64.0f);
+				ImGui::Checkbox("Show cluster load", &showClusterLoad);
+				ImGui::Text("Assignment: %.2f ms", clusterAssignTime * 1000.0f);
+				ImGui::Text("Visible lights: %u / %u", (unsigned int)clusteredLights.getVisibleLightCount(), (unsigned int)clusteredLights.getLightCount());
+				ImGui::Text("Lights per cluster: %.1f avg, %u max", clusteredLights.getAverageLightsPerCluster(), clusteredLights.getMaxLightsPerCluster());
+			}
+			if (!useClustered && ImGui::CollapsingHeader("Lights")) {
 				ImGui::DragInt("Lights Number", &lightsAmount, 1.0, 0, MAX_LIGHTS);
 				for (int i = 0; i < lightsAmount; i++) {
 					ImGui::PushID(i);
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <ew/modelLoader.h>
+
+#include <assimp/cimport.h>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+//Usage: modelLoaderBenchmark <model.obj|model.glb> [iterations]
+//Loads the same file with ew::loadModel and with aiImportFile, then prints the fastest and median time of each.
+//Both run once untimed first, so the file is in the page cache and the thread pool is started
+
+namespace {
+	//Post processing that makes assimp's output match the native loaders:
+	//triangles, deduplicated vertices, smooth normals where the file has none and node transforms flattened into one mesh
+	const unsigned int ASSIMP_FLAGS = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices
+		| aiProcess_GenSmoothNormals | aiProcess_PreTransformVertices;
+
+	struct LoadResult {
+		bool loaded = false;
+		size_t vertices = 0;
+		size_t indices = 0;
+	};
+	LoadResult loadNative(const char* path) {
+		LoadResult result;
+		ew::MeshData meshData;
+		result.loaded = ew::loadModel(path, &meshData);
+		result.vertices = meshData.vertices.size();
+		result.indices = meshData.indices.size();
+		return result;
+	}
+	LoadResult loadAssimp(const char* path) {
+		LoadResult result;
+		const aiScene* scene = aiImportFile(path, ASSIMP_FLAGS);
+		if (scene == NULL)
+			return result;
+		result.loaded = true;
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+		{
+			result.vertices += scene->mMeshes[i]->mNumVertices;
+			result.indices += (size_t)scene->mMeshes[i]->mNumFaces * 3;
+		}
+		aiReleaseImport(scene);
+		return result;
+	}
+	//Returns false if any load failed
+	bool benchmark(const char* name, const char* path, int iterations, LoadResult(*load)(const char*)) {
+		LoadResult result = load(path);
+		if (!result.loaded) {
+			printf("%s failed to load %s\n", name, path);
+			return false;
+		}
+		std::vector<double> times(iterations);
+		for (int i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			result = load(path);
+			times[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		std::sort(times.begin(), times.end());
+		printf("%-8s min %8.2f ms  median %8.2f ms  %zu vertices  %zu indices\n",
+			name, times[0], times[iterations / 2], result.vertices, result.indices);
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printf("Usage: %s <model.obj|model.glb> [iterations]\n", argv[0]);
+		return 1;
+	}
+	const char* path = argv[1];
+	int iterations = argc > 2 ? atoi(argv[2]) : 10;
+	if (iterations < 1) {
+		iterations = 1;
+	}
+	printf("%s, %d iterations\n", path, iterations);
+	bool ok = benchmark("ew", path, iterations, loadNative);
+	ok = benchmark("assimp", path, iterations, loadAssimp) && ok;
+	return ok ? 0 : 1;
+}
@@ -1,186 +1,219 @@
 #include "procGen.h"
+#include "../ew/threadPool.h"
+#include "../ew/procGen.h"
 
 namespace am {
+	// rows per parallelFor range, small meshes stay on the calling thread
+	static const size_t MIN_ROWS_PER_RANGE = 32;
+
 	ew::MeshData createPlane(float width, float height, int subdivisions) {
 		ew::MeshData mesh;
-		ew::Vertex v;
-		for (float i = 0; i <= subdivisions; i++) {
-			for (float j = 0; j <= subdivisions; j++) {
-				v.pos.x = width * (j / subdivisions);
-				v.pos.z = -height * (i / subdivisions);
-				v.normal = ew::Vec3(0, 1, 0);
-				v.uv = ew::Vec2(i/subdivisions,j/subdivisions);
-				mesh.vertices.push_back(v);
+		int columns = subdivisions + 1;
+		mesh.vertices.resize((size_t)columns * columns);
+		mesh.indices.resize((size_t)subdivisions * subdivisions * 6);
+		ew::Vertex* vertices = mesh.vertices.data();
+		unsigned int* indices = mesh.indices.data();
+
+		ew::getThreadPool().parallelFor(columns, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			for (int i = (int)rowBegin; i < (int)rowEnd; i++) {
+				ew::Vertex* v = vertices + (size_t)i * columns;
+				float u = (float)i / subdivisions;
+				for (int j = 0; j <= subdivisions; j++, v++) {
+					float t = (float)j / subdivisions;
+					v->pos = ew::Vec3(width * t, 0, -height * u);
+					v->normal = ew::Vec3(0, 1, 0);
+					v->uv = ew::Vec2(u, t);
+				}
 			}
-		}
+		});
 
-		int columns = subdivisions + 1;
-		int start;
-		for (int i = 0; i < subdivisions; i++) {
-			for (int j = 0; j < subdivisions; j++) {
-				start = i * columns + j;
-				//bottom right triangle
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
-				//top left triangle
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start);
+		ew::getThreadPool().parallelFor(subdivisions, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			unsigned int* out = indices + rowBegin * subdivisions * 6;
+			for (int i = (int)rowBegin; i < (int)rowEnd; i++) {
+				for (int j = 0; j < subdivisions; j++) {
+					unsigned int start = i * columns + j;
+					//bottom right triangle
+					*out++ = start;
+					*out++ = start + 1;
+					*out++ = start + columns + 1;
+					//top left triangle
+					*out++ = start + columns + 1;
+					*out++ = start + columns;
+					*out++ = start;
+				}
 			}
+		});
 
-		
-		}
+		ew::finishGeneratedMesh(&mesh);
 		return mesh;
 	}
 
 	ew::MeshData createCylinder(float height, float radius, int numSegments) {
 		ew::MeshData mesh;
-		ew::Vertex v;
 		float topY = height / 2;
 		float bottomY = -topY;
+		int columns = numSegments + 1;
+		// center, 4 rings (top cap, top side, bottom side, bottom cap), center
+		mesh.vertices.resize((size_t)columns * 4 + 2);
+		// top cap, sides, bottom cap
+		mesh.indices.resize((size_t)columns * 3 + (size_t)columns * 6 + (size_t)numSegments * 3);
+		ew::Vertex* vertices = mesh.vertices.data();
+		unsigned int* indices = mesh.indices.data();
+
 		// top center
-		v.pos.x = 0;
-		v.pos.y = topY;
-		v.pos.z = 0;
-		v.normal = (0, 1, 0);
-		v.uv = ew::Vec2(0.5, 0.5);
-		mesh.vertices.push_back(v);
-		// top ring
+		vertices[0].pos = ew::Vec3(0, topY, 0);
+		vertices[0].normal = ew::Vec3(0, 1, 0);
+		vertices[0].uv = ew::Vec2(0.5, 0.5);
+
+		// each segment writes its vertex in all four rings, cos/sin once per segment
 		float thetaStep = ew::PI * 2 / numSegments;
-		float theta;
-		for (float i = 0; i <= numSegments; i++) {
-			theta = i * thetaStep;
-			v.pos.x = cos(theta) * radius;
-			v.pos.z = sin(theta) * radius;
-			v.pos.y = topY;
-			v.normal = ew::Vec3(0, 1, 0);
-			v.uv = ew::Vec2(v.pos.x / radius / 2 + 0.5, v.pos.z / radius / 2 + 0.5);
-			mesh.vertices.push_back(v);
-		}
-		for (float i = 0; i <= numSegments; i++) {
-			theta = i * thetaStep;
-			v.pos.x = cos(theta) * radius;
-			v.pos.z = sin(theta) * radius;
-			v.pos.y = topY;
-			v.uv = ew::Vec2(i/numSegments, 1);
-			v.normal = ew::Normalize(ew::Vec3(v.pos.x, 0, v.pos.z));
-			mesh.vertices.push_back(v);
-		}
-		//bottom ring
-		for (float i = 0; i <= numSegments; i++) {
-			theta = i * thetaStep;
-			v.pos.x = cos(theta) * radius;
-			v.pos.z = sin(theta) * radius;
-			v.pos.y = bottomY;
-			v.uv = ew::Vec2(i / numSegments, 0);
-			v.normal = ew::Normalize(ew::Vec3(v.pos.x, 0, v.pos.z));
-			mesh.vertices.push_back(v);
-		}
-		for (float i = 0; i <= numSegments; i++) {
-			theta = i * thetaStep;
-			v.pos.x = cos(theta) * radius;
-			v.pos.z = sin(theta) * radius;
-			v.pos.y = bottomY;
-			v.uv = ew::Vec2(v.pos.x / radius / 2 + 0.5, v.pos.z / radius / 2 + 0.5);
-			v.normal = ew::Vec3(0, -1, 0);
-			mesh.vertices.push_back(v);
-		}
+		ew::getThreadPool().parallelFor(columns, MIN_ROWS_PER_RANGE, [=](size_t begin, size_t end) {
+			for (int i = (int)begin; i < (int)end; i++) {
+				float theta = i * thetaStep;
+				float x = cos(theta) * radius;
+				float z = sin(theta) * radius;
+				float u = (float)i / numSegments;
+				ew::Vec2 capUV = ew::Vec2(x / radius / 2 + 0.5, z / radius / 2 + 0.5);
+				ew::Vec3 sideNormal = ew::Normalize(ew::Vec3(x, 0, z));
+
+				ew::Vertex& topCap = vertices[1 + i];
+				topCap.pos = ew::Vec3(x, topY, z);
+				topCap.normal = ew::Vec3(0, 1, 0);
+				topCap.uv = capUV;
+
+				ew::Vertex& topSide = vertices[1 + columns + i];
+				topSide.pos = ew::Vec3(x, topY, z);
+				topSide.normal = sideNormal;
+				topSide.uv = ew::Vec2(u, 1);
+
+				ew::Vertex& bottomSide = vertices[1 + columns * 2 + i];
+				bottomSide.pos = ew::Vec3(x, bottomY, z);
+				bottomSide.normal = sideNormal;
+				bottomSide.uv = ew::Vec2(u, 0);
+
+				ew::Vertex& bottomCap = vertices[1 + columns * 3 + i];
+				bottomCap.pos = ew::Vec3(x, bottomY, z);
+				bottomCap.normal = ew::Vec3(0, -1, 0);
+				bottomCap.uv = capUV;
+			}
+		});
+
 		//bottom center
-		v.pos.x = 0;
-		v.pos.y = bottomY;
-		v.pos.z = 0;
-		v.normal = (0, -1, 0);
-		v.uv = ew::Vec2(0.5, 0.5);
-		mesh.vertices.push_back(v);
+		ew::Vertex& bottomCenter = mesh.vertices.back();
+		bottomCenter.pos = ew::Vec3(0, bottomY, 0);
+		bottomCenter.normal = ew::Vec3(0, -1, 0);
+		bottomCenter.uv = ew::Vec2(0.5, 0.5);
 
+		unsigned int* out = indices;
 		// top ring indices
 		int start = 1;
 		int center = 0;
 		for (int i = 0; i <= numSegments; i++) {
-			mesh.indices.push_back(start + i);
-			mesh.indices.push_back(center);
-			mesh.indices.push_back(start + i + 1);
+			*out++ = start + i;
+			*out++ = center;
+			*out++ = start + i + 1;
 		}
 
 		int sideStart = numSegments + 1;
-		int columns = numSegments + 1;
 		for (int i = 0; i < columns; i++) {
 			start = sideStart + i;
 			// first triangle
-			mesh.indices.push_back(start);
-			mesh.indices.push_back(start + 1);
-			mesh.indices.push_back(start + columns);
+			*out++ = start;
+			*out++ = start + 1;
+			*out++ = start + columns;
 			// second triangle
-			mesh.indices.push_back(start + 1);
-			mesh.indices.push_back(start + columns + 1);
-			mesh.indices.push_back(start + columns);
+			*out++ = start + 1;
+			*out++ = start + columns + 1;
+			*out++ = start + columns;
 		}
 
 		// bottom ring indices
 		start = numSegments * 3 + 4;
 		center = mesh.vertices.size() - 1;
 		for (int i = 0; i < numSegments; i++) {
-			mesh.indices.push_back(center);
-			mesh.indices.push_back(start + i);
-			mesh.indices.push_back(start + i + 1);
+			*out++ = center;
+			*out++ = start + i;
+			*out++ = start + i + 1;
 		}
 
+		ew::finishGeneratedMesh(&mesh);
 		return mesh;
 	}
 
 	ew::MeshData createSphere(float radius, int numSegments) {
 		ew::MeshData mesh;
-		ew::Vertex v;
+		int columns = numSegments + 1;
+		size_t capIndices = (size_t)numSegments * 3;
+		size_t sideRows = numSegments > 2 ? numSegments - 2 : 0;
+		mesh.vertices.resize((size_t)columns * columns);
+		mesh.indices.resize(capIndices * 2 + sideRows * numSegments * 6);
+		ew::Vertex* vertices = mesh.vertices.data();
+		unsigned int* indices = mesh.indices.data();
+
+		// theta only depends on the column, so its cos/sin are shared by every row
 		float thetaStep = 2 * ew::PI / numSegments;
 		float phiStep = ew::PI / numSegments;
-		for (float i = 0; i <= numSegments; i++) {
-			// first and last row converge at poles
-			float phi = i * phiStep;
-			for (float j = 0; j <= numSegments; j++) {
-				float theta = j * thetaStep;
-				v.pos.x = radius * cos(theta) * sin(phi);
-				v.pos.y = radius * cos(phi);
-				v.pos.z = radius * sin(theta) * sin(phi);
-				v.normal = ew::Normalize(ew::Vec3(v.pos.x, v.pos.y, v.pos.z));
-				v.uv = ew::Vec2(j/numSegments,i/numSegments);
-				mesh.vertices.push_back(v);
-			}
+		std::vector<float> cosTheta(columns), sinTheta(columns);
+		for (int j = 0; j < columns; j++) {
+			cosTheta[j] = cos(j * thetaStep);
+			sinTheta[j] = sin(j * thetaStep);
 		}
+		const float* cosT = cosTheta.data();
+		const float* sinT = sinTheta.data();
+
+		ew::getThreadPool().parallelFor(columns, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			for (int i = (int)rowBegin; i < (int)rowEnd; i++) {
+				// first and last row converge at poles
+				float phi = i * phiStep;
+				float cosPhi = cos(phi);
+				float sinPhi = sin(phi);
+				ew::Vertex* v = vertices + (size_t)i * columns;
+				for (int j = 0; j <= numSegments; j++, v++) {
+					// already unit length, no need to normalize
+					v->normal = ew::Vec3(cosT[j] * sinPhi, cosPhi, sinT[j] * sinPhi);
+					v->pos = v->normal * radius;
+					v->uv = ew::Vec2((float)j / numSegments, (float)i / numSegments);
+				}
+			}
+		});
 
-		// indices 
+		// indices
+		unsigned int* out = indices;
 		int poleStart = 0;
 		int sideStart = numSegments + 1;
 		for (int i = 0; i < numSegments; i++) {
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(poleStart + i);
-			mesh.indices.push_back(sideStart + i + 1);
+			*out++ = sideStart + i;
+			*out++ = poleStart + i;
+			*out++ = sideStart + i + 1;
 		}
-		
-		int columns = numSegments + 1;
-		for (int i = 1; i < numSegments - 1; i++) {
-			for (int j = 0; j < numSegments; j++) {
-				int start = i * columns + j;
-				//triangle 1
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				// triangle 2
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns);
-				
+
+		ew::getThreadPool().parallelFor(sideRows, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			unsigned int* out = indices + capIndices + rowBegin * numSegments * 6;
+			for (int i = (int)rowBegin + 1; i < (int)rowEnd + 1; i++) {
+				for (int j = 0; j < numSegments; j++) {
+					unsigned int start = i * columns + j;
+					//triangle 1
+					*out++ = start;
+					*out++ = start + 1;
+					*out++ = start + columns;
+					// triangle 2
+					*out++ = start + 1;
+					*out++ = start + columns + 1;
+					*out++ = start + columns;
+				}
 			}
-		}
+		});
 
+		out = indices + capIndices + sideRows * numSegments * 6;
 		poleStart = mesh.vertices.size() - 1;
 		sideStart = poleStart - numSegments - 1;
 		for (int i = 0; i < numSegments; i++) {
-			mesh.indices.push_back(sideStart - i);
-			mesh.indices.push_back(poleStart - i);
-			mesh.indices.push_back(sideStart - i - 1);
+			*out++ = sideStart - i;
+			*out++ = poleStart - i;
+			*out++ = sideStart - i - 1;
 		}
 
+		ew::finishGeneratedMesh(&mesh);
 		return mesh;
 	}
-}
\ No newline at end of file
+}
@@ -57,26 +57,56 @@ namespace am {
 		std::string vertexShaderSource = loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = loadShaderSourceFromFile(fragmentShader.c_str());
 		m_id = createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_uniformLocations = ew::getActiveUniformLocations(m_id);
+	}
+	// hash table lookup instead of glGetUniformLocation, returns -1 for inactive uniforms
+	int Shader::getUniformLocation(const std::string& name) const {
+		m_lookupCount++;
+		auto it = m_uniformLocations.find(name);
+		return it != m_uniformLocations.end() ? it->second : -1;
 	}
 	void Shader::use() {
 		glUseProgram(m_id);
 	}
 	void Shader::setInt(const std::string& name, int v) const {
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1i(getUniformLocation(name), v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const {
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1f(getUniformLocation(name), v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const {
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const {
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	void Shader::setMat4(const std::string& name, const ew::Mat4& v) const {
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &v[0][0]);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &v[0][0]);
+	}
+	ew::UniformId Shader::getUniformId(const std::string& name) const {
+		ew::UniformId id;
+		id.location = getUniformLocation(name);
+		return id;
+	}
+	void Shader::setInt(ew::UniformId id, int v) const {
+		glUniform1i(id.location, v);
+	}
+	void Shader::setFloat(ew::UniformId id, float v) const {
+		glUniform1f(id.location, v);
+	}
+	void Shader::setVec2(ew::UniformId id, float x, float y) const {
+		glUniform2f(id.location, x, y);
+	}
+	void Shader::setVec3(ew::UniformId id, float x, float y, float z) const {
+		glUniform3f(id.location, x, y, z);
+	}
+	void Shader::setVec4(ew::UniformId id, float x, float y, float z, float w) const {
+		glUniform4f(id.location, x, y, z, w);
+	}
+	void Shader::setMat4(ew::UniformId id, const ew::Mat4& v) const {
+		glUniformMatrix4fv(id.location, 1, GL_FALSE, &v[0][0]);
 	}
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 #include <sstream>
 #include <fstream>
+#include <unordered_map>
 #include "../ew/external/glad.h"
 #include "../ew/ewMath/mat4.h"
+#include "../ew/shader.h"
 
 namespace am {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
@@ -19,7 +21,23 @@ namespace am {
 		void setVec3(const std::string& name, float x, float y, float z) const;
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void Shader::setMat4(const std::string& name, const ew::Mat4& v) const;
+
+		// resolve a uniform once, then set it by id without any string lookup
+		ew::UniformId getUniformId(const std::string& name) const;
+		void setInt(ew::UniformId id, int v) const;
+		void setFloat(ew::UniformId id, float v) const;
+		void setVec2(ew::UniformId id, float x, float y) const;
+		void setVec3(ew::UniformId id, float x, float y, float z) const;
+		void setVec4(ew::UniformId id, float x, float y, float z, float w) const;
+		void setMat4(ew::UniformId id, const ew::Mat4& v) const;
+
+		// number of uniform name lookups since the last reset
+		unsigned int getLookupCount() const { return m_lookupCount; }
+		void resetLookupCount() { m_lookupCount = 0; }
 	private:
+		int getUniformLocation(const std::string& name) const;
 		unsigned int m_id; // opengl program handle
+		std::unordered_map<std::string, int> m_uniformLocations; // active uniforms, reflected after linking
+		mutable unsigned int m_lookupCount = 0;
 	};
 }
\ No newline at end of file
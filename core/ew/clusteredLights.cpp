@@ -0,0 +1,292 @@
+#include "clusteredLights.h"
+#include "frustum.h"
+#include "threadPool.h"
+#include "ewMath/simd.h"
+#include "external/glad.h"
+#include <math.h>
+
+namespace ew {
+	namespace {
+		using namespace ew::simd;
+
+		//Nearest plane the depth slices start from, so log() stays finite for cameras with a zero near plane
+		const float MIN_CLUSTER_NEAR = 0.001f;
+
+		inline int clampInt(int v, int min, int max) {
+			return v < min ? min : (v > max ? max : v);
+		}
+
+		/// <summary>
+		/// View space plane through the clip space line x = ndc (axis 0) or y = ndc (axis 1).
+		/// Points with a larger ndc coordinate are on its positive side. Works for perspective and orthographic projections.
+		/// </summary>
+		Plane tilePlane(const ew::Mat4& projection, int axis, float ndc) {
+			ew::Vec4 row = ew::Vec4(projection[0][axis], projection[1][axis], projection[2][axis], projection[3][axis]);
+			ew::Vec4 w = ew::Vec4(projection[0][3], projection[1][3], projection[2][3], projection[3][3]);
+			ew::Vec4 p = row - w * ndc;
+			ew::Vec3 normal = ew::Vec3(p.x, p.y, p.z);
+			float length = ew::Magnitude(normal);
+			Plane plane;
+			plane.normal = normal / length;
+			plane.distance = p.w / length;
+			return plane;
+		}
+
+		/// <summary>
+		/// Counts the planes each lane's sphere is entirely in front of (above) and entirely behind (below).
+		/// With the planes ordered along an axis, the tiles a sphere can touch run from above - 1 to numPlanes - 1 - below.
+		/// </summary>
+		inline void countPlanes(const Plane* planes, int numPlanes, FloatN x, FloatN y, FloatN z, FloatN radius, FloatN* above, FloatN* below) {
+			FloatN one = setN(1.0f);
+			FloatN negRadius = subN(setN(0.0f), radius);
+			*above = setN(0.0f);
+			*below = setN(0.0f);
+			for (int k = 0; k < numPlanes; k++)
+			{
+				const Plane& plane = planes[k];
+				FloatN d = addN(addN(mulN(x, setN(plane.normal.x)), mulN(y, setN(plane.normal.y))),
+					addN(mulN(z, setN(plane.normal.z)), setN(plane.distance)));
+				*above = addN(*above, andN(geN(d, radius), one));
+				*below = addN(*below, andN(geN(negRadius, d), one));
+			}
+		}
+
+		void uploadStorage(unsigned int buffer, size_t* capacity, const void* data, size_t bytes) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			if (bytes > *capacity) {
+				//Headroom so a slowly growing light count does not reallocate every frame
+				*capacity = bytes + bytes / 2;
+				glBufferData(GL_SHADER_STORAGE_BUFFER, *capacity, NULL, GL_DYNAMIC_DRAW);
+			}
+			if (bytes > 0) {
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data);
+			}
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+	}
+
+	ClusteredLights::ClusteredLights() :m_clusterBlock(CLUSTER_BLOCK_BINDING)
+	{
+		m_slices.resize(CLUSTER_GRID_Z);
+		m_clusters.resize(CLUSTER_COUNT);
+		glGenBuffers(1, &m_lightBuffer);
+		glGenBuffers(1, &m_clusterBuffer);
+		glGenBuffers(1, &m_indexBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightCluster) * CLUSTER_COUNT, NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		//Empty storage buffers cannot be bound, so both lists start with room for one entry
+		m_lightCapacity = sizeof(PointLight);
+		m_indexCapacity = sizeof(unsigned int);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_lightCapacity, NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_indexCapacity, NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		bind();
+	}
+	ClusteredLights::~ClusteredLights()
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		glDeleteBuffers(1, &m_clusterBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+
+	/// <summary>
+	/// Three passes. Every light is moved to view space and given a range of depth slices. Then each slice, as its own job,
+	/// clips the spheres touching it to the slice's depth range and tests them against the tile planes LANES at a time,
+	/// counting lights per cluster. A prefix sum turns the counts into offsets, and the slices fill the index list in parallel.
+	/// </summary>
+	void ClusteredLights::update(const std::vector<PointLight>& lights, const ew::Camera& camera, int screenWidth, int screenHeight)
+	{
+		ThreadPool& pool = getThreadPool();
+		size_t numLights = lights.size();
+		m_lightCount = numLights;
+		ew::Mat4 view = camera.ViewMatrix();
+		ew::Mat4 projection = camera.ProjectionMatrix();
+		float nearDepth = fmaxf(camera.nearPlane, MIN_CLUSTER_NEAR);
+		float farDepth = fmaxf(camera.farPlane, nearDepth * 2.0f);
+		float depthScale = (float)CLUSTER_GRID_Z / logf(farDepth / nearDepth);
+		float depthBias = depthScale * logf(nearDepth);
+
+		Plane xPlanes[CLUSTER_GRID_X + 1];
+		Plane yPlanes[CLUSTER_GRID_Y + 1];
+		for (int k = 0; k <= CLUSTER_GRID_X; k++)
+			xPlanes[k] = tilePlane(projection, 0, -1.0f + 2.0f * k / CLUSTER_GRID_X);
+		for (int k = 0; k <= CLUSTER_GRID_Y; k++)
+			yPlanes[k] = tilePlane(projection, 1, -1.0f + 2.0f * k / CLUSTER_GRID_Y);
+
+		//View space spheres and the depth slices they overlap. An empty range means the light is out of depth range
+		m_viewX.resize(numLights);
+		m_viewY.resize(numLights);
+		m_viewZ.resize(numLights);
+		m_radius.resize(numLights);
+		m_firstSlice.resize(numLights);
+		m_lastSlice.resize(numLights);
+		pool.parallelFor(numLights, 256, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				ew::Vec4 p = view * ew::Vec4(lights[i].position, 1.0f);
+				float radius = lights[i].radius;
+				float depth = -p.z;
+				m_viewX[i] = p.x;
+				m_viewY[i] = p.y;
+				m_viewZ[i] = p.z;
+				m_radius[i] = radius;
+				if (radius <= 0.0f || depth + radius < nearDepth || depth - radius > farDepth) {
+					m_firstSlice[i] = 1;
+					m_lastSlice[i] = 0;
+					continue;
+				}
+				m_firstSlice[i] = clampInt((int)floorf(logf(fmaxf(depth - radius, nearDepth)) * depthScale - depthBias), 0, CLUSTER_GRID_Z - 1);
+				m_lastSlice[i] = clampInt((int)floorf(logf(fminf(depth + radius, farDepth)) * depthScale - depthBias), 0, CLUSTER_GRID_Z - 1);
+			}
+		});
+
+		//Tile ranges per slice, and light counts of the slice's clusters
+		pool.parallelFor(CLUSTER_GRID_Z, 1, [&](size_t begin, size_t end) {
+			for (size_t z = begin; z < end; z++)
+			{
+				Slice& slice = m_slices[z];
+				slice.x.clear();
+				slice.y.clear();
+				slice.z.clear();
+				slice.radius.clear();
+				slice.lights.clear();
+				slice.ranges.clear();
+				float sliceNear = expf(((float)z + depthBias) / depthScale);
+				float sliceFar = expf(((float)z + 1.0f + depthBias) / depthScale);
+				for (size_t i = 0; i < numLights; i++)
+				{
+					if ((int)z < m_firstSlice[i] || (int)z > m_lastSlice[i])
+						continue;
+					//The part of the sphere inside the slice fits in a smaller sphere centered on the slice
+					float depth = -m_viewZ[i];
+					float clamped = fminf(fmaxf(depth, sliceNear), sliceFar);
+					float offset = depth - clamped;
+					float radiusSquared = m_radius[i] * m_radius[i] - offset * offset;
+					if (radiusSquared <= 0.0f)
+						continue;
+					slice.x.push_back(m_viewX[i]);
+					slice.y.push_back(m_viewY[i]);
+					slice.z.push_back(-clamped);
+					slice.radius.push_back(sqrtf(radiusSquared));
+					slice.lights.push_back((unsigned int)i);
+				}
+				size_t count = slice.lights.size();
+				size_t padded = (count + LANES - 1) / LANES * LANES;
+				slice.x.resize(padded, 0.0f);
+				slice.y.resize(padded, 0.0f);
+				slice.z.resize(padded, 0.0f);
+				slice.radius.resize(padded, 0.0f);
+
+				LightCluster* clusters = m_clusters.data() + z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+				for (int c = 0; c < CLUSTER_GRID_X * CLUSTER_GRID_Y; c++)
+					clusters[c].count = 0;
+				for (size_t i = 0; i < count; i += LANES)
+				{
+					FloatN x = loadN(&slice.x[i]), y = loadN(&slice.y[i]), cz = loadN(&slice.z[i]), radius = loadN(&slice.radius[i]);
+					FloatN right, left, top, bottom;
+					countPlanes(xPlanes, CLUSTER_GRID_X + 1, x, y, cz, radius, &right, &left);
+					countPlanes(yPlanes, CLUSTER_GRID_Y + 1, x, y, cz, radius, &top, &bottom);
+					float counts[4][LANES];
+					storeN(counts[0], right);
+					storeN(counts[1], left);
+					storeN(counts[2], top);
+					storeN(counts[3], bottom);
+					for (size_t lane = 0; lane < LANES && i + lane < count; lane++)
+					{
+						LightRange range;
+						range.light = slice.lights[i + lane];
+						range.minX = clampInt((int)counts[0][lane] - 1, 0, CLUSTER_GRID_X);
+						range.maxX = CLUSTER_GRID_X - (int)counts[1][lane];
+						range.minY = clampInt((int)counts[2][lane] - 1, 0, CLUSTER_GRID_Y);
+						range.maxY = CLUSTER_GRID_Y - (int)counts[3][lane];
+						range.maxX = range.maxX > CLUSTER_GRID_X - 1 ? CLUSTER_GRID_X - 1 : range.maxX;
+						range.maxY = range.maxY > CLUSTER_GRID_Y - 1 ? CLUSTER_GRID_Y - 1 : range.maxY;
+						if (range.minX > range.maxX || range.minY > range.maxY)
+							continue;
+						slice.ranges.push_back(range);
+						for (int ty = range.minY; ty <= range.maxY; ty++)
+						{
+							for (int tx = range.minX; tx <= range.maxX; tx++)
+								clusters[ty * CLUSTER_GRID_X + tx].count++;
+						}
+					}
+				}
+			}
+		});
+
+		size_t total = 0;
+		size_t occupied = 0;
+		m_maxLightsPerCluster = 0;
+		for (LightCluster& cluster : m_clusters)
+		{
+			cluster.offset = (unsigned int)total;
+			total += cluster.count;
+			occupied += cluster.count > 0;
+			m_maxLightsPerCluster = cluster.count > m_maxLightsPerCluster ? cluster.count : m_maxLightsPerCluster;
+		}
+		m_averageLightsPerCluster = occupied > 0 ? (float)total / occupied : 0.0f;
+
+		//Counts are rebuilt while filling, so they double as write cursors
+		m_indices.resize(total);
+		pool.parallelFor(CLUSTER_GRID_Z, 1, [&](size_t begin, size_t end) {
+			for (size_t z = begin; z < end; z++)
+			{
+				LightCluster* clusters = m_clusters.data() + z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+				for (int c = 0; c < CLUSTER_GRID_X * CLUSTER_GRID_Y; c++)
+					clusters[c].count = 0;
+				for (const LightRange& range : m_slices[z].ranges)
+				{
+					for (int ty = range.minY; ty <= range.maxY; ty++)
+					{
+						for (int tx = range.minX; tx <= range.maxX; tx++)
+						{
+							LightCluster& cluster = clusters[ty * CLUSTER_GRID_X + tx];
+							m_indices[cluster.offset + cluster.count++] = range.light;
+						}
+					}
+				}
+			}
+		});
+
+		//Reuses the slice ranges of the first pass as a per light visited flag
+		m_visibleLightCount = 0;
+		m_firstSlice.assign(numLights, 0);
+		for (const Slice& slice : m_slices)
+		{
+			for (const LightRange& range : slice.ranges)
+			{
+				m_visibleLightCount += m_firstSlice[range.light] == 0;
+				m_firstSlice[range.light] = 1;
+			}
+		}
+
+		uploadStorage(m_lightBuffer, &m_lightCapacity, lights.data(), sizeof(PointLight) * numLights);
+		uploadStorage(m_indexBuffer, &m_indexCapacity, m_indices.data(), sizeof(unsigned int) * m_indices.size());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(LightCluster) * CLUSTER_COUNT, m_clusters.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		ClusterData clusterData;
+		clusterData.view = view;
+		clusterData.clusterCounts[0] = CLUSTER_GRID_X;
+		clusterData.clusterCounts[1] = CLUSTER_GRID_Y;
+		clusterData.clusterCounts[2] = CLUSTER_GRID_Z;
+		clusterData.clusterCounts[3] = 0;
+		clusterData.screenSize = ew::Vec2((float)screenWidth, (float)screenHeight);
+		clusterData.depthScale = depthScale;
+		clusterData.depthBias = depthBias;
+		m_clusterBlock.update(clusterData);
+		bind();
+	}
+
+	void ClusteredLights::bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_SSBO_BINDING, m_lightBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_SSBO_BINDING, m_clusterBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_SSBO_BINDING, m_indexBuffer);
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_clusterBlock.getBinding(), m_clusterBlock.getHandle());
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include "camera.h"
+#include "uniformBuffer.h"
+#include "uniformBlocks.h"
+
+namespace ew {
+	//Shader storage binding points of the light lists. 0 belongs to DrawList
+	const unsigned int POINT_LIGHT_SSBO_BINDING = 1;
+	const unsigned int LIGHT_CLUSTER_SSBO_BINDING = 2;
+	const unsigned int LIGHT_INDEX_SSBO_BINDING = 3;
+
+	//Screen tiles across and down, and exponential depth slices between the camera's near and far planes
+	const int CLUSTER_GRID_X = 16;
+	const int CLUSTER_GRID_Y = 9;
+	const int CLUSTER_GRID_Z = 24;
+	const int CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+	/// <summary>
+	/// std430 mirror of
+	/// struct PointLight { vec3 position; float radius; vec3 color; float pad; };
+	/// layout(std430) readonly buffer PointLightBuffer { PointLight _PointLights[]; };
+	/// The light reaches no further than radius.
+	/// </summary>
+	struct PointLight {
+		ew::Vec3 position; //World space
+		float radius;
+		ew::Vec3 color;
+		float pad0;
+	};
+	static_assert(sizeof(PointLight) == 32, "PointLight layout does not match std430");
+
+	/// <summary>
+	/// std430 mirror of the per cluster light list, a range of the index buffer:
+	/// layout(std430) readonly buffer LightClusterBuffer { uvec2 _LightClusters[]; };
+	/// layout(std430) readonly buffer LightIndexBuffer { uint _LightIndices[]; };
+	/// Cluster (x, y, z) is _LightClusters[(z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x], with y = 0 at the bottom of the screen.
+	/// </summary>
+	struct LightCluster {
+		unsigned int offset;
+		unsigned int count;
+	};
+
+	/// <summary>
+	/// Clustered forward lighting. Splits the view frustum into a CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z grid,
+	/// finds the clusters each point light's sphere touches on the thread pool, and uploads the lights, the per cluster
+	/// ranges and the flattened light indices to storage buffers, plus a ClusterData uniform block to look them up with.
+	/// A fragment then shades only the lights of its own cluster, so its cost follows the local light density
+	/// instead of the total light count.
+	/// </summary>
+	class ClusteredLights {
+	public:
+		ClusteredLights();
+		~ClusteredLights();
+		ClusteredLights(const ClusteredLights&) = delete;
+		ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+		//Assigns lights to the clusters of camera's view and uploads the results.
+		//Call once per frame, on the thread that owns the GL context, before drawing with a clustered program
+		void update(const std::vector<PointLight>& lights, const ew::Camera& camera, int screenWidth, int screenHeight);
+		//Rebinds the storage buffers, in case something else claimed their binding points
+		void bind()const;
+		inline size_t getLightCount()const { return m_lightCount; }
+		//Lights that touched at least one cluster in the last update
+		inline size_t getVisibleLightCount()const { return m_visibleLightCount; }
+		//Total light references over all clusters
+		inline size_t getIndexCount()const { return m_indices.size(); }
+		inline unsigned int getMaxLightsPerCluster()const { return m_maxLightsPerCluster; }
+		//Average over clusters holding at least one light
+		inline float getAverageLightsPerCluster()const { return m_averageLightsPerCluster; }
+		inline const std::vector<LightCluster>& getClusters()const { return m_clusters; }
+		inline const std::vector<unsigned int>& getIndices()const { return m_indices; }
+	private:
+		//A light's tile rectangle within one depth slice
+		struct LightRange {
+			unsigned int light;
+			int minX, maxX, minY, maxY;
+		};
+		//Lights overlapping one depth slice, clipped to it. Each slice is assigned by a single job
+		struct Slice {
+			std::vector<float> x, y, z, radius;
+			std::vector<unsigned int> lights;
+			std::vector<LightRange> ranges;
+		};
+		std::vector<float> m_viewX, m_viewY, m_viewZ, m_radius;
+		std::vector<int> m_firstSlice, m_lastSlice;
+		std::vector<Slice> m_slices;
+		std::vector<LightCluster> m_clusters;
+		std::vector<unsigned int> m_indices;
+		UniformBuffer<ClusterData> m_clusterBlock;
+		unsigned int m_lightBuffer = 0;
+		unsigned int m_clusterBuffer = 0;
+		unsigned int m_indexBuffer = 0;
+		size_t m_lightCapacity = 0; //Bytes allocated for each buffer
+		size_t m_indexCapacity = 0;
+		size_t m_lightCount = 0;
+		size_t m_visibleLightCount = 0;
+		unsigned int m_maxLightsPerCluster = 0;
+		float m_averageLightsPerCluster = 0.0f;
+	};
+}
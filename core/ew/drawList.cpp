@@ -0,0 +1,139 @@
+#include "drawList.h"
+#include <algorithm>
+#include <stdio.h>
+#include "external/glad.h"
+
+namespace ew {
+	DrawList::~DrawList()
+	{
+		if (m_initialized) {
+			glDeleteBuffers(1, &m_commandBuffer);
+			glDeleteBuffers(1, &m_drawDataBuffer);
+		}
+	}
+	void DrawList::initialize()
+	{
+		glGenBuffers(1, &m_commandBuffer);
+		glGenBuffers(1, &m_drawDataBuffer);
+		m_initialized = true;
+	}
+	void DrawList::clear()
+	{
+		m_records.clear();
+		m_instances.clear();
+		m_uploaded = false;
+	}
+	void DrawList::add(const Mesh& mesh, const ew::Mat4& model, const ew::Mat4& normalMatrix, unsigned int material)
+	{
+		DrawData data;
+		data.model = model;
+		data.normalMatrix = normalMatrix;
+		add(mesh, &data, 1, material);
+	}
+	void DrawList::add(const Mesh& mesh, const DrawData* instances, unsigned int instanceCount, unsigned int material)
+	{
+		if (!mesh.isPooled()) {
+			printf("DrawList only supports meshes created in a GeometryPool\n");
+			return;
+		}
+		if (instanceCount == 0)
+			return;
+		const GeometryAllocation& allocation = mesh.getAllocation();
+		DrawRecord record;
+		record.command.count = allocation.numIndices;
+		record.command.instanceCount = instanceCount;
+		record.command.firstIndex = allocation.firstIndex;
+		record.command.baseVertex = allocation.baseVertex;
+		record.command.baseInstance = 0;
+		record.firstInstance = m_instances.size();
+		record.material = material;
+		m_records.push_back(record);
+		m_instances.insert(m_instances.end(), instances, instances + instanceCount);
+		m_uploaded = false;
+	}
+	void DrawList::upload()
+	{
+		if (!m_initialized) {
+			initialize();
+		}
+		if (m_uploaded) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_SSBO_BINDING, m_drawDataBuffer);
+			return;
+		}
+		std::stable_sort(m_records.begin(), m_records.end(), [](const DrawRecord& a, const DrawRecord& b) {
+			return a.material < b.material;
+		});
+		//Lay the instances out in command order, so each command's range starts at its baseInstance
+		m_commands.resize(m_records.size());
+		m_drawData.resize(m_instances.size());
+		size_t instance = 0;
+		for (size_t i = 0; i < m_records.size(); i++)
+		{
+			const DrawRecord& record = m_records[i];
+			m_commands[i] = record.command;
+			m_commands[i].baseInstance = (unsigned int)instance;
+			std::copy(m_instances.begin() + record.firstInstance, m_instances.begin() + record.firstInstance + record.command.instanceCount,
+				m_drawData.begin() + instance);
+			instance += record.command.instanceCount;
+		}
+
+		//Upload, growing the buffers only when needed
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		if (m_commands.size() > m_commandCapacity) {
+			m_commandCapacity = m_commands.size();
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * m_commandCapacity, m_commands.data(), GL_DYNAMIC_DRAW);
+		}
+		else {
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * m_commands.size(), m_commands.data());
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+		if (m_drawData.size() > m_drawDataCapacity) {
+			m_drawDataCapacity = m_drawData.size();
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawData) * m_drawDataCapacity, m_drawData.data(), GL_DYNAMIC_DRAW);
+		}
+		else {
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DrawData) * m_drawData.size(), m_drawData.data());
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_SSBO_BINDING, m_drawDataBuffer);
+		m_uploaded = true;
+	}
+	void DrawList::submit(const GeometryPool& pool, const std::function<void(unsigned int material)>& bindMaterial)
+	{
+		m_submitCount = 0;
+		if (m_records.empty())
+			return;
+		upload();
+
+		//One multi draw per run of records sharing a material
+		pool.bind();
+		size_t start = 0;
+		while (start < m_records.size())
+		{
+			unsigned int material = m_records[start].material;
+			size_t end = start + 1;
+			while (end < m_records.size() && m_records[end].material == material) {
+				end++;
+			}
+			if (bindMaterial) {
+				bindMaterial(material);
+			}
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+				(const void*)(sizeof(DrawElementsIndirectCommand) * start), (GLsizei)(end - start), 0);
+			m_submitCount++;
+			start = end;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	void DrawList::submitPositions(const GeometryPool& pool)
+	{
+		if (m_records.empty())
+			return;
+		upload();
+		//Materials do not matter without shading, so everything goes out in one call
+		pool.bindPositions();
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)0, (GLsizei)m_records.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include "mesh.h"
+#include "geometryPool.h"
+
+namespace ew {
+	//Shader storage binding point of the per draw data array
+	const unsigned int DRAW_DATA_SSBO_BINDING = 0;
+
+	//Layout read by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand {
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	/// <summary>
+	/// std430 mirror of the per instance data fetched in the vertex shader:
+	/// struct DrawData { mat4 model; mat4 normalMatrix; };
+	/// layout(std430) readonly buffer DrawDataBuffer { DrawData _DrawData[]; };
+	/// indexed with gl_BaseInstanceARB + gl_InstanceID. Each command's baseInstance is the index of its first instance
+	/// </summary>
+	struct DrawData {
+		ew::Mat4 model;
+		ew::Mat4 normalMatrix;
+	};
+	static_assert(sizeof(DrawData) == 128, "DrawData layout does not match std430");
+
+	/// <summary>
+	/// Collects draws of pooled meshes during a frame and submits them with one
+	/// glMultiDrawElementsIndirect call per material.
+	/// </summary>
+	class DrawList {
+	public:
+		DrawList() {};
+		~DrawList();
+		DrawList(const DrawList&) = delete;
+		DrawList& operator=(const DrawList&) = delete;
+
+		void clear();
+		//Mesh must belong to the GeometryPool passed to submit
+		void add(const Mesh& mesh, const ew::Mat4& model, const ew::Mat4& normalMatrix, unsigned int material = 0);
+		//Draws instanceCount copies of mesh with one command, instance i using instances[i]
+		void add(const Mesh& mesh, const DrawData* instances, unsigned int instanceCount, unsigned int material = 0);
+		/// <summary>
+		/// Sorts by material, uploads every command and its instances' draw data, then issues the draws.
+		/// bindMaterial is called before each material's draws and may be empty.
+		/// </summary>
+		void submit(const GeometryPool& pool, const std::function<void(unsigned int material)>& bindMaterial = nullptr);
+		//Draws every record in one call through the pool's position stream, for a depth pre-pass or a shadow map.
+		//The upload is kept, so a submit afterwards with no add or clear in between reuses it
+		void submitPositions(const GeometryPool& pool);
+		//Records, each one draw command
+		inline size_t size()const { return m_records.size(); }
+		inline size_t getInstanceCount()const { return m_instances.size(); }
+		//glMultiDrawElementsIndirect calls issued by the last submit
+		inline unsigned int getSubmitCount()const { return m_submitCount; }
+	private:
+		struct DrawRecord {
+			DrawElementsIndirectCommand command; //baseInstance is assigned by upload
+			size_t firstInstance; //Into m_instances, in add order
+			unsigned int material;
+		};
+		void initialize();
+		//Sorts and uploads the records unless they are unchanged since the last upload, and binds the buffers
+		void upload();
+		std::vector<DrawRecord> m_records;
+		std::vector<DrawData> m_instances;
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<DrawData> m_drawData;
+		bool m_initialized = false;
+		bool m_uploaded = false;
+		unsigned int m_commandBuffer = 0;
+		unsigned int m_drawDataBuffer = 0;
+		size_t m_commandCapacity = 0;
+		size_t m_drawDataCapacity = 0;
+		unsigned int m_submitCount = 0;
+	};
+}
@@ -4,10 +4,12 @@
 
 #pragma once
 #include "vec4.h"
+#include "simd.h"
 #include <cstddef>
 
 namespace ew {
-	struct Mat4 {
+	//Column major. Aligned to 16 bytes so each column can be loaded into a single SIMD register
+	struct alignas(16) Mat4 {
 	private:
 		float n[4][4];
 	public:
@@ -42,38 +44,102 @@ namespace ew {
 			return (*reinterpret_cast<const Vec4*>(n[i]));
 		}
 		inline friend Vec4 operator * (const Mat4& m, const Vec4& v) {
+#if defined(EW_SIMD_SSE)
+			//Linear combination of the columns of m
+			__m128 r = _mm_mul_ps(_mm_load_ps(m.n[0]), _mm_set1_ps(v.x));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(m.n[1]), _mm_set1_ps(v.y)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(m.n[2]), _mm_set1_ps(v.z)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(m.n[3]), _mm_set1_ps(v.w)));
+			Vec4 out;
+			_mm_storeu_ps(&out.x, r);
+			return out;
+#else
 			return Vec4(
 				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
 				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
 				m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * v.w,
 				m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
 			);
+#endif
 		}
 		inline friend Mat4 operator * (const Mat4& l, const Mat4& r) {
 			Mat4 m;
+#if defined(EW_SIMD_AVX)
+			//Two result columns per iteration. Each column of l is duplicated into both 128 bit lanes,
+			//and the matching coefficients of r's columns j and j+1 are broadcast within each lane.
+			//Mat4 is only 16 byte aligned, so the column pairs use unaligned access
+			const __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[0]));
+			const __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[1]));
+			const __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[2]));
+			const __m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[3]));
+			for (int j = 0; j < 4; j += 2) {
+				const __m256 rc = _mm256_loadu_ps(r.n[j]);
+				__m256 c = _mm256_mul_ps(l0, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(0, 0, 0, 0)));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l1, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(1, 1, 1, 1))));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l2, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(2, 2, 2, 2))));
+				c = _mm256_add_ps(c, _mm256_mul_ps(l3, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm256_storeu_ps(m.n[j], c);
+			}
+#elif defined(EW_SIMD_SSE)
+			//Column j of the result is l * (column j of r)
+			const __m128 l0 = _mm_load_ps(l.n[0]);
+			const __m128 l1 = _mm_load_ps(l.n[1]);
+			const __m128 l2 = _mm_load_ps(l.n[2]);
+			const __m128 l3 = _mm_load_ps(l.n[3]);
+			for (int j = 0; j < 4; j++) {
+				__m128 c = _mm_mul_ps(l0, _mm_set1_ps(r.n[j][0]));
+				c = _mm_add_ps(c, _mm_mul_ps(l1, _mm_set1_ps(r.n[j][1])));
+				c = _mm_add_ps(c, _mm_mul_ps(l2, _mm_set1_ps(r.n[j][2])));
+				c = _mm_add_ps(c, _mm_mul_ps(l3, _mm_set1_ps(r.n[j][3])));
+				_mm_store_ps(m.n[j], c);
+			}
+#else
 			//Row 0
 			m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
 			m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
 			m[2][0] = l[0][0] * r[2][0] + l[1][0] * r[2][1] + l[2][0] * r[2][2] + l[3][0] * r[2][3];//dot(l_row_0,r_col_2)
 			m[3][0] = l[0][0] * r[3][0] + l[1][0] * r[3][1] + l[2][0] * r[3][2] + l[3][0] * r[3][3];//dot(l_row_0,r_col_3)
-			// Row 1		  		    		  		    		  		    		  
+			// Row 1
 			m[0][1] = l[0][1] * r[0][0] + l[1][1] * r[0][1] + l[2][1] * r[0][2] + l[3][1] * r[0][3];//dot(l_row_1,r_col_0)
 			m[1][1] = l[0][1] * r[1][0] + l[1][1] * r[1][1] + l[2][1] * r[1][2] + l[3][1] * r[1][3];//dot(l_row_1,r_col_1)
 			m[2][1] = l[0][1] * r[2][0] + l[1][1] * r[2][1] + l[2][1] * r[2][2] + l[3][1] * r[2][3];//dot(l_row_1,r_col_2)
 			m[3][1] = l[0][1] * r[3][0] + l[1][1] * r[3][1] + l[2][1] * r[3][2] + l[3][1] * r[3][3];//dot(l_row_1,r_col_3)
-			// Row  2		  		    		  		    		  		    		  
+			// Row  2
 			m[0][2] = l[0][2] * r[0][0] + l[1][2] * r[0][1] + l[2][2] * r[0][2] + l[3][2] * r[0][3];//dot(l_row_2,r_col_0)
 			m[1][2] = l[0][2] * r[1][0] + l[1][2] * r[1][1] + l[2][2] * r[1][2] + l[3][2] * r[1][3];//dot(l_row_2,r_col_1)
 			m[2][2] = l[0][2] * r[2][0] + l[1][2] * r[2][1] + l[2][2] * r[2][2] + l[3][2] * r[2][3];//dot(l_row_2,r_col_2)
 			m[3][2] = l[0][2] * r[3][0] + l[1][2] * r[3][1] + l[2][2] * r[3][2] + l[3][2] * r[3][3];//dot(l_row_2,r_col_3)
-			// Row  3		 			 		 			 		 			 		    
+			// Row  3
 			m[0][3] = l[0][3] * r[0][0] + l[1][3] * r[0][1] + l[2][3] * r[0][2] + l[3][3] * r[0][3];//dot(l_row_3,r_col_0)
 			m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
 			m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
 			m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
-			return m;		  
+#endif
+			return m;
 		}
 	};
+	//Swaps rows and columns
+	inline Mat4 Transpose(const Mat4& m) {
+		Mat4 t;
+#if defined(EW_SIMD_SSE)
+		__m128 c0 = _mm_load_ps(&m[0].x);
+		__m128 c1 = _mm_load_ps(&m[1].x);
+		__m128 c2 = _mm_load_ps(&m[2].x);
+		__m128 c3 = _mm_load_ps(&m[3].x);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_store_ps(&t[0].x, c0);
+		_mm_store_ps(&t[1].x, c1);
+		_mm_store_ps(&t[2].x, c2);
+		_mm_store_ps(&t[3].x, c3);
+#else
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				t[i][j] = m[j][i];
+			}
+		}
+#endif
+		return t;
+	}
 	inline Mat4 IdentityMatrix() {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
@@ -82,4 +148,36 @@ namespace ew {
 			0.0f, 0.0f, 0.0f, 1.0f
 		);
 	}
+	//General inverse by cofactor expansion. Singular matrices return the identity
+	inline Mat4 Inverse(const Mat4& m) {
+		float a[16], inv[16];
+		for (int i = 0; i < 16; i++) {
+			a[i] = m[i / 4][i % 4];
+		}
+		inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+		float determinant = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+		if (determinant == 0.0f) {
+			return IdentityMatrix();
+		}
+		Mat4 r;
+		for (int i = 0; i < 16; i++) {
+			r[i / 4][i % 4] = inv[i] / determinant;
+		}
+		return r;
+	}
 }
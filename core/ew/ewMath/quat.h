@@ -0,0 +1,66 @@
+#pragma once
+#include <math.h>
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	//Unit quaternion representing a rotation
+	struct Quat {
+		float x, y, z, w;
+
+		Quat() :x(0), y(0), z(0), w(1) {};
+		Quat(float x, float y, float z, float w) :x(x), y(y), z(z), w(w) {};
+
+		friend Quat operator*(const Quat& a, const Quat& b);
+	};
+
+	//Hamilton product. Applies b first, then a
+	inline Quat operator*(const Quat& a, const Quat& b) {
+		return Quat(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		);
+	}
+
+	inline Quat Normalize(const Quat& q) {
+		float mag = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		if (mag == 0)
+			return Quat();
+		return Quat(q.x / mag, q.y / mag, q.z / mag, q.w / mag);
+	}
+
+	//Rotation of rad radians around a normalized axis
+	inline Quat AxisAngle(const Vec3& axis, float rad) {
+		float s = sinf(rad * 0.5f);
+		return Quat(axis.x * s, axis.y * s, axis.z * s, cosf(rad * 0.5f));
+	}
+
+	//Euler angles in radians, applied in the same order as ew::Transform (Z, then X, then Y)
+	inline Quat FromEuler(const Vec3& rad) {
+		return AxisAngle(Vec3(0, 1, 0), rad.y)
+			* AxisAngle(Vec3(1, 0, 0), rad.x)
+			* AxisAngle(Vec3(0, 0, 1), rad.z);
+	}
+
+	//Rotates v by q
+	inline Vec3 Rotate(const Quat& q, const Vec3& v) {
+		Vec3 u = Vec3(q.x, q.y, q.z);
+		Vec3 t = Cross(u, v) * 2.0f;
+		return v + t * q.w + Cross(u, t);
+	}
+
+	//Rotation matrix of a unit quaternion
+	inline Mat4 ToMat4(const Quat& q) {
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		return Mat4(
+			1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy), 0.0f,
+			2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0f,
+			2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+//Picks the widest SIMD instruction set the compiler is targeting.
+//Define EW_NO_SIMD before including ewMath to force the scalar fallback.
+#if !defined(EW_NO_SIMD)
+	#if defined(__AVX__)
+		#define EW_SIMD_AVX 1
+	#endif
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define EW_SIMD_SSE 1
+	#endif
+	//Hardware float <-> half conversion. MSVC has no __F16C__, but every /arch:AVX2 target supports it.
+	//GCC and Clang only allow the intrinsics when F16C itself is enabled, -mavx2 alone is not enough
+	#if defined(EW_SIMD_AVX) && (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__)))
+		#define EW_SIMD_F16C 1
+	#endif
+#endif
+
+#if defined(EW_SIMD_AVX)
+	#include <immintrin.h>
+#elif defined(EW_SIMD_SSE)
+	#include <emmintrin.h>
+#endif
+
+#include <math.h>
+
+namespace ew {
+	namespace simd {
+		//Thin wrappers so kernels are written once for every lane width.
+		//Comparisons return a lane mask that can be combined with andN and read back with movemaskN
+#if defined(EW_SIMD_AVX)
+		typedef __m256 FloatN;
+		const size_t LANES = 8;
+		inline FloatN loadN(const float* p) { return _mm256_loadu_ps(p); }
+		inline void storeN(float* p, FloatN a) { _mm256_storeu_ps(p, a); }
+		inline FloatN setN(float v) { return _mm256_set1_ps(v); }
+		inline FloatN addN(FloatN a, FloatN b) { return _mm256_add_ps(a, b); }
+		inline FloatN subN(FloatN a, FloatN b) { return _mm256_sub_ps(a, b); }
+		inline FloatN mulN(FloatN a, FloatN b) { return _mm256_mul_ps(a, b); }
+		inline FloatN minN(FloatN a, FloatN b) { return _mm256_min_ps(a, b); }
+		inline FloatN maxN(FloatN a, FloatN b) { return _mm256_max_ps(a, b); }
+		inline FloatN roundN(FloatN a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		inline FloatN geN(FloatN a, FloatN b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		inline FloatN andN(FloatN a, FloatN b) { return _mm256_and_ps(a, b); }
+		inline int movemaskN(FloatN m) { return _mm256_movemask_ps(m); }
+#elif defined(EW_SIMD_SSE)
+		typedef __m128 FloatN;
+		const size_t LANES = 4;
+		inline FloatN loadN(const float* p) { return _mm_loadu_ps(p); }
+		inline void storeN(float* p, FloatN a) { _mm_storeu_ps(p, a); }
+		inline FloatN setN(float v) { return _mm_set1_ps(v); }
+		inline FloatN addN(FloatN a, FloatN b) { return _mm_add_ps(a, b); }
+		inline FloatN subN(FloatN a, FloatN b) { return _mm_sub_ps(a, b); }
+		inline FloatN mulN(FloatN a, FloatN b) { return _mm_mul_ps(a, b); }
+		inline FloatN minN(FloatN a, FloatN b) { return _mm_min_ps(a, b); }
+		inline FloatN maxN(FloatN a, FloatN b) { return _mm_max_ps(a, b); }
+		inline FloatN roundN(FloatN a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+		inline FloatN geN(FloatN a, FloatN b) { return _mm_cmpge_ps(a, b); }
+		inline FloatN andN(FloatN a, FloatN b) { return _mm_and_ps(a, b); }
+		inline int movemaskN(FloatN m) { return _mm_movemask_ps(m); }
+#else
+		typedef float FloatN;
+		const size_t LANES = 1;
+		inline FloatN loadN(const float* p) { return *p; }
+		inline void storeN(float* p, FloatN a) { *p = a; }
+		inline FloatN setN(float v) { return v; }
+		inline FloatN addN(FloatN a, FloatN b) { return a + b; }
+		inline FloatN subN(FloatN a, FloatN b) { return a - b; }
+		inline FloatN mulN(FloatN a, FloatN b) { return a * b; }
+		inline FloatN minN(FloatN a, FloatN b) { return a < b ? a : b; }
+		inline FloatN maxN(FloatN a, FloatN b) { return a > b ? a : b; }
+		inline FloatN roundN(FloatN a) { return nearbyintf(a); }
+		inline FloatN geN(FloatN a, FloatN b) { return a >= b ? 1.0f : 0.0f; }
+		inline FloatN andN(FloatN a, FloatN b) { return a * b; }
+		inline int movemaskN(FloatN m) { return m != 0.0f ? 1 : 0; }
+#endif
+	}
+}
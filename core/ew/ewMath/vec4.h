@@ -45,6 +45,7 @@ namespace ew {
 		this->x += rhs.x;
 		this->y += rhs.y;
 		this->z += rhs.z;
+		this->w += rhs.w;
 		return *this;
 	}
 
@@ -52,6 +53,7 @@ namespace ew {
 		this->x -= rhs.x;
 		this->y -= rhs.y;
 		this->z -= rhs.z;
+		this->w -= rhs.w;
 		return *this;
 	}
 
@@ -60,6 +62,7 @@ namespace ew {
 		this->x *= rhs;
 		this->y *= rhs;
 		this->z *= rhs;
+		this->w *= rhs;
 		return *this;
 	}
 
@@ -0,0 +1,170 @@
+#include "frustum.h"
+#include "ewMath/simd.h"
+
+namespace ew {
+	namespace {
+		const size_t BLOCK_SIZE = 8;
+
+		using namespace ew::simd;
+
+		inline Plane normalizePlane(float a, float b, float c, float d) {
+			float invLength = 1.0f / sqrtf(a * a + b * b + c * c);
+			Plane plane;
+			plane.normal = ew::Vec3(a, b, c) * invLength;
+			plane.distance = d * invLength;
+			return plane;
+		}
+
+		/// <summary>
+		/// Pushes the indices of the set bits in mask, ignoring lanes at or past count
+		/// </summary>
+		inline void appendVisible(int mask, size_t first, size_t count, std::vector<unsigned int>* visible) {
+			for (size_t lane = 0; lane < LANES; lane++)
+			{
+				if ((mask & (1 << lane)) && first + lane < count) {
+					visible->push_back((unsigned int)(first + lane));
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Gribb/Hartmann extraction. Each plane is the sum or difference of the w row and another row of the matrix.
+	/// </summary>
+	Frustum extractFrustum(const ew::Mat4& viewProjection)
+	{
+		const ew::Mat4& m = viewProjection;
+		//Row r of a column major matrix is (m[0][r], m[1][r], m[2][r], m[3][r])
+		ew::Vec4 row0 = ew::Vec4(m[0].x, m[1].x, m[2].x, m[3].x);
+		ew::Vec4 row1 = ew::Vec4(m[0].y, m[1].y, m[2].y, m[3].y);
+		ew::Vec4 row2 = ew::Vec4(m[0].z, m[1].z, m[2].z, m[3].z);
+		ew::Vec4 row3 = ew::Vec4(m[0].w, m[1].w, m[2].w, m[3].w);
+
+		Frustum frustum;
+		ew::Vec4 p[Frustum::PLANE_COUNT] = {
+			row3 + row0, row3 - row0,
+			row3 + row1, row3 - row1,
+			row3 + row2, row3 - row2
+		};
+		for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			frustum.planes[i] = normalizePlane(p[i].x, p[i].y, p[i].z, p[i].w);
+		}
+		return frustum;
+	}
+	/// <summary>
+	/// Arvo's method for the box. The sphere radius is scaled by the largest axis scale.
+	/// </summary>
+	Bounds transformBounds(const Bounds& bounds, const ew::Mat4& model)
+	{
+		ew::Vec3 center = (bounds.min + bounds.max) * 0.5f;
+		ew::Vec3 extents = (bounds.max - bounds.min) * 0.5f;
+		ew::Vec4 worldCenter = model * ew::Vec4(center, 1.0f);
+		ew::Vec3 worldExtents = ew::Vec3(
+			fabsf(model[0].x) * extents.x + fabsf(model[1].x) * extents.y + fabsf(model[2].x) * extents.z,
+			fabsf(model[0].y) * extents.x + fabsf(model[1].y) * extents.y + fabsf(model[2].y) * extents.z,
+			fabsf(model[0].z) * extents.x + fabsf(model[1].z) * extents.y + fabsf(model[2].z) * extents.z
+		);
+
+		Bounds out;
+		ew::Vec3 c = ew::Vec3(worldCenter.x, worldCenter.y, worldCenter.z);
+		out.min = c - worldExtents;
+		out.max = c + worldExtents;
+		ew::Vec4 sphereCenter = model * ew::Vec4(bounds.center, 1.0f);
+		out.center = ew::Vec3(sphereCenter.x, sphereCenter.y, sphereCenter.z);
+		float scaleX = ew::Magnitude(ew::Vec3(model[0].x, model[0].y, model[0].z));
+		float scaleY = ew::Magnitude(ew::Vec3(model[1].x, model[1].y, model[1].z));
+		float scaleZ = ew::Magnitude(ew::Vec3(model[2].x, model[2].y, model[2].z));
+		out.radius = bounds.radius * fmaxf(scaleX, fmaxf(scaleY, scaleZ));
+		return out;
+	}
+	bool isVisible(const Frustum& frustum, const Bounds& worldBounds)
+	{
+		for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const Plane& plane = frustum.planes[i];
+			if (ew::Dot(plane.normal, worldBounds.center) + plane.distance < -worldBounds.radius)
+				return false;
+			//Corner furthest along the plane normal
+			ew::Vec3 positive = ew::Vec3(
+				plane.normal.x >= 0.0f ? worldBounds.max.x : worldBounds.min.x,
+				plane.normal.y >= 0.0f ? worldBounds.max.y : worldBounds.min.y,
+				plane.normal.z >= 0.0f ? worldBounds.max.z : worldBounds.min.z);
+			if (ew::Dot(plane.normal, positive) + plane.distance < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	void BoundsBatch::clear()
+	{
+		m_count = 0;
+	}
+	size_t BoundsBatch::add(const Bounds& worldBounds)
+	{
+		if (m_count == centerX.size()) {
+			size_t padded = centerX.size() + BLOCK_SIZE;
+			centerX.resize(padded, 0.0f); centerY.resize(padded, 0.0f); centerZ.resize(padded, 0.0f);
+			radius.resize(padded, 0.0f);
+			minX.resize(padded, 0.0f); minY.resize(padded, 0.0f); minZ.resize(padded, 0.0f);
+			maxX.resize(padded, 0.0f); maxY.resize(padded, 0.0f); maxZ.resize(padded, 0.0f);
+		}
+		size_t i = m_count++;
+		centerX[i] = worldBounds.center.x; centerY[i] = worldBounds.center.y; centerZ[i] = worldBounds.center.z;
+		radius[i] = worldBounds.radius;
+		minX[i] = worldBounds.min.x; minY[i] = worldBounds.min.y; minZ[i] = worldBounds.min.z;
+		maxX[i] = worldBounds.max.x; maxY[i] = worldBounds.max.y; maxZ[i] = worldBounds.max.z;
+		return i;
+	}
+
+	size_t cullSpheres(const Frustum& frustum, const BoundsBatch& batch, std::vector<unsigned int>* visible)
+	{
+		size_t before = visible->size();
+		size_t count = batch.size();
+		for (size_t block = 0; block < count; block += BLOCK_SIZE)
+		{
+			for (size_t lane = 0; lane < BLOCK_SIZE; lane += LANES)
+			{
+				size_t i = block + lane;
+				FloatN cx = loadN(&batch.centerX[i]), cy = loadN(&batch.centerY[i]), cz = loadN(&batch.centerZ[i]);
+				FloatN negRadius = subN(setN(0.0f), loadN(&batch.radius[i]));
+				FloatN inside = geN(setN(0.0f), setN(0.0f));
+				for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+				{
+					const Plane& plane = frustum.planes[p];
+					FloatN d = addN(addN(mulN(cx, setN(plane.normal.x)), mulN(cy, setN(plane.normal.y))),
+						addN(mulN(cz, setN(plane.normal.z)), setN(plane.distance)));
+					inside = andN(inside, geN(d, negRadius));
+				}
+				appendVisible(movemaskN(inside), i, count, visible);
+			}
+		}
+		return visible->size() - before;
+	}
+	size_t cullBoxes(const Frustum& frustum, const BoundsBatch& batch, std::vector<unsigned int>* visible)
+	{
+		size_t before = visible->size();
+		size_t count = batch.size();
+		for (size_t block = 0; block < count; block += BLOCK_SIZE)
+		{
+			for (size_t lane = 0; lane < BLOCK_SIZE; lane += LANES)
+			{
+				size_t i = block + lane;
+				FloatN inside = geN(setN(0.0f), setN(0.0f));
+				for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+				{
+					//The plane normal is shared by every lane, so the positive corner is chosen per array, not per lane
+					const Plane& plane = frustum.planes[p];
+					FloatN px = loadN(plane.normal.x >= 0.0f ? &batch.maxX[i] : &batch.minX[i]);
+					FloatN py = loadN(plane.normal.y >= 0.0f ? &batch.maxY[i] : &batch.minY[i]);
+					FloatN pz = loadN(plane.normal.z >= 0.0f ? &batch.maxZ[i] : &batch.minZ[i]);
+					FloatN d = addN(addN(mulN(px, setN(plane.normal.x)), mulN(py, setN(plane.normal.y))),
+						addN(mulN(pz, setN(plane.normal.z)), setN(plane.distance)));
+					inside = andN(inside, geN(d, setN(0.0f)));
+				}
+				appendVisible(movemaskN(inside), i, count, visible);
+			}
+		}
+		return visible->size() - before;
+	}
+}
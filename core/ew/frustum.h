@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+#include "mesh.h"
+
+namespace ew {
+	//Points p where Dot(normal, p) + distance >= 0 are on the inner side
+	struct Plane {
+		ew::Vec3 normal;
+		float distance;
+	};
+
+	struct Frustum {
+		enum PlaneIndex {
+			PLANE_LEFT = 0,
+			PLANE_RIGHT,
+			PLANE_BOTTOM,
+			PLANE_TOP,
+			PLANE_NEAR,
+			PLANE_FAR,
+			PLANE_COUNT
+		};
+		Plane planes[PLANE_COUNT];
+	};
+
+	//World space planes of a view projection matrix, e.g. camera.ProjectionMatrix() * camera.ViewMatrix()
+	Frustum extractFrustum(const ew::Mat4& viewProjection);
+	//Bounds of a mesh after being transformed by model
+	Bounds transformBounds(const Bounds& bounds, const ew::Mat4& model);
+	//Single sphere then box test, for a handful of objects
+	bool isVisible(const Frustum& frustum, const Bounds& worldBounds);
+
+	/// <summary>
+	/// World space bounds stored as structure of arrays so the cull functions can test 8 at a time.
+	/// Arrays are padded to a multiple of 8.
+	/// </summary>
+	class BoundsBatch {
+	public:
+		void clear();
+		//Returns the index reported by the cull functions
+		size_t add(const Bounds& worldBounds);
+		inline size_t size()const { return m_count; }
+
+		std::vector<float> centerX, centerY, centerZ, radius;
+		std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	private:
+		size_t m_count = 0;
+	};
+
+	//Appends the index of every sphere intersecting the frustum to visible, in ascending order. Returns the number appended
+	size_t cullSpheres(const Frustum& frustum, const BoundsBatch& batch, std::vector<unsigned int>* visible);
+	//Same as cullSpheres using the boxes. Tighter for long or flat objects
+	size_t cullBoxes(const Frustum& frustum, const BoundsBatch& batch, std::vector<unsigned int>* visible);
+}
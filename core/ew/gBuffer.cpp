@@ -0,0 +1,87 @@
+#include "gBuffer.h"
+#include "external/glad.h"
+#include <stdio.h>
+
+namespace ew {
+	namespace {
+		unsigned int createTarget(int width, int height, GLenum internalFormat, GLenum format, GLenum type) {
+			unsigned int texture;
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+			//Read with texelFetch, one texel per pixel
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			return texture;
+		}
+	}
+
+	GBuffer::GBuffer(int width, int height) :m_width(width), m_height(height)
+	{
+		glGenVertexArrays(1, &m_emptyVAO);
+		create();
+	}
+	GBuffer::~GBuffer()
+	{
+		destroy();
+		glDeleteVertexArrays(1, &m_emptyVAO);
+	}
+	void GBuffer::resize(int width, int height)
+	{
+		if (width == m_width && height == m_height)
+			return;
+		destroy();
+		m_width = width;
+		m_height = height;
+		create();
+	}
+	void GBuffer::bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		const GLenum drawBuffers[COLOR_ATTACHMENT_COUNT] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+		glDrawBuffers(COLOR_ATTACHMENT_COUNT, drawBuffers);
+	}
+	void GBuffer::bindTextures(int firstUnit) const
+	{
+		for (int i = 0; i < COLOR_ATTACHMENT_COUNT; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+			glBindTexture(GL_TEXTURE_2D, m_colors[i]);
+		}
+		glActiveTexture(GL_TEXTURE0 + firstUnit + COLOR_ATTACHMENT_COUNT);
+		glBindTexture(GL_TEXTURE_2D, m_depth);
+		glActiveTexture(GL_TEXTURE0);
+	}
+	void GBuffer::drawFullscreenTriangle() const
+	{
+		glBindVertexArray(m_emptyVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	void GBuffer::create()
+	{
+		m_colors[0] = createTarget(m_width, m_height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+		m_colors[1] = createTarget(m_width, m_height, GL_RG16F, GL_RG, GL_HALF_FLOAT);
+		m_colors[2] = createTarget(m_width, m_height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+		m_depth = createTarget(m_width, m_height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &m_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		for (int i = 0; i < COLOR_ATTACHMENT_COUNT; i++)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_colors[i], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			printf("GBuffer framebuffer incomplete: 0x%x\n", status);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	void GBuffer::destroy()
+	{
+		glDeleteFramebuffers(1, &m_fbo);
+		glDeleteTextures(COLOR_ATTACHMENT_COUNT, m_colors);
+		glDeleteTextures(1, &m_depth);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+namespace ew {
+	/// <summary>
+	/// Render targets of the deferred geometry pass, 16 bytes per pixel:
+	/// 0 albedo RGBA8, 1 octahedral world normal RG16F, 2 material RGBA8 (ambientK, diffuseK, specular, log2(shininess) / 8),
+	/// and a 24 bit depth texture the lighting pass reconstructs world positions from.
+	/// </summary>
+	class GBuffer {
+	public:
+		static const int COLOR_ATTACHMENT_COUNT = 3;
+
+		GBuffer(int width, int height);
+		~GBuffer();
+		GBuffer(const GBuffer&) = delete;
+		GBuffer& operator=(const GBuffer&) = delete;
+
+		//Reallocates the targets if the size changed
+		void resize(int width, int height);
+		//Binds the framebuffer with all color attachments enabled for drawing
+		void bind()const;
+		//Binds albedo, normal, material and depth to texture units firstUnit to firstUnit + 3
+		void bindTextures(int firstUnit = 0)const;
+		//Draws one triangle covering the viewport with no vertex attributes, for the lighting pass.
+		//The vertex shader builds it from gl_VertexID
+		void drawFullscreenTriangle()const;
+		inline int getWidth()const { return m_width; }
+		inline int getHeight()const { return m_height; }
+		inline unsigned int getFramebuffer()const { return m_fbo; }
+		inline unsigned int getColorTexture(int i)const { return m_colors[i]; }
+		inline unsigned int getDepthTexture()const { return m_depth; }
+	private:
+		void create();
+		void destroy();
+		int m_width = 0;
+		int m_height = 0;
+		unsigned int m_fbo = 0;
+		unsigned int m_colors[COLOR_ATTACHMENT_COUNT] = {};
+		unsigned int m_depth = 0;
+		unsigned int m_emptyVAO = 0;
+	};
+}
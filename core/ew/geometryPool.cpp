@@ -0,0 +1,178 @@
+#include "geometryPool.h"
+#include <stdio.h>
+#include <iterator>
+#include <vector>
+#include "external/glad.h"
+
+namespace ew {
+	FreeListAllocator::FreeListAllocator(unsigned int capacity)
+		:m_capacity(capacity)
+	{
+		if (capacity > 0) {
+			m_freeBlocks[0] = capacity;
+		}
+	}
+	bool FreeListAllocator::allocate(unsigned int size, unsigned int* offset)
+	{
+		if (size == 0) {
+			*offset = 0;
+			return true;
+		}
+		for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); it++)
+		{
+			if (it->second < size)
+				continue;
+			*offset = it->first;
+			unsigned int remaining = it->second - size;
+			m_freeBlocks.erase(it);
+			if (remaining > 0) {
+				m_freeBlocks[*offset + size] = remaining;
+			}
+			return true;
+		}
+		return false;
+	}
+	void FreeListAllocator::release(unsigned int offset, unsigned int size)
+	{
+		if (size == 0)
+			return;
+		auto next = m_freeBlocks.lower_bound(offset);
+		//Merge with the following block
+		if (next != m_freeBlocks.end() && offset + size == next->first) {
+			size += next->second;
+			next = m_freeBlocks.erase(next);
+		}
+		//Merge with the preceding block
+		if (next != m_freeBlocks.begin()) {
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset) {
+				prev->second += size;
+				return;
+			}
+		}
+		m_freeBlocks[offset] = size;
+	}
+	unsigned int FreeListAllocator::getFreeSize() const
+	{
+		unsigned int total = 0;
+		for (auto& block : m_freeBlocks)
+		{
+			total += block.second;
+		}
+		return total;
+	}
+
+	GeometryPool::GeometryPool(unsigned int maxVertices, unsigned int maxIndices, bool positionStream)
+		:m_vertexAllocator(maxVertices), m_indexAllocator(maxIndices)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glBindVertexArray(m_vao);
+
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * (size_t)maxVertices, NULL, GL_STATIC_DRAW);
+
+		glGenBuffers(1, &m_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * (size_t)maxIndices, NULL, GL_STATIC_DRAW);
+
+		setVertexAttributes();
+
+		if (positionStream) {
+			//Shares the EBO, so allocations draw the same way through either VAO
+			glGenVertexArrays(1, &m_positionVao);
+			glBindVertexArray(m_positionVao);
+			glGenBuffers(1, &m_positionVbo);
+			glBindBuffer(GL_ARRAY_BUFFER, m_positionVbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(ew::Vec3) * (size_t)maxVertices, NULL, GL_STATIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+			setPositionAttributes();
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	GeometryPool::~GeometryPool()
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		if (m_positionVao != 0) {
+			glDeleteVertexArrays(1, &m_positionVao);
+			glDeleteBuffers(1, &m_positionVbo);
+		}
+	}
+	bool GeometryPool::allocate(const MeshData& meshData, GeometryAllocation* allocation)
+	{
+		unsigned int numVertices = meshData.vertices.size();
+		unsigned int numIndices = meshData.indices.size();
+		unsigned int baseVertex, firstIndex;
+		if (!m_vertexAllocator.allocate(numVertices, &baseVertex)) {
+			printf("Geometry pool is out of vertex space (%u requested)\n", numVertices);
+			return false;
+		}
+		if (!m_indexAllocator.allocate(numIndices, &firstIndex)) {
+			printf("Geometry pool is out of index space (%u requested)\n", numIndices);
+			m_vertexAllocator.release(baseVertex, numVertices);
+			return false;
+		}
+		allocation->baseVertex = baseVertex;
+		allocation->numVertices = numVertices;
+		allocation->firstIndex = firstIndex;
+		allocation->numIndices = numIndices;
+
+		//The EBO is VAO state, so bind the VAO rather than the EBO alone
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		if (numVertices > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * (size_t)baseVertex, sizeof(Vertex) * (size_t)numVertices, meshData.vertices.data());
+		}
+		if (numIndices > 0) {
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * (size_t)firstIndex, sizeof(unsigned int) * (size_t)numIndices, meshData.indices.data());
+		}
+		if (m_positionVao != 0 && numVertices > 0) {
+			std::vector<ew::Vec3> positions(numVertices);
+			for (unsigned int i = 0; i < numVertices; i++)
+				positions[i] = meshData.vertices[i].pos;
+			glBindBuffer(GL_ARRAY_BUFFER, m_positionVbo);
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(ew::Vec3) * (size_t)baseVertex, sizeof(ew::Vec3) * (size_t)numVertices, positions.data());
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return true;
+	}
+	void GeometryPool::release(const GeometryAllocation& allocation)
+	{
+		m_vertexAllocator.release(allocation.baseVertex, allocation.numVertices);
+		m_indexAllocator.release(allocation.firstIndex, allocation.numIndices);
+	}
+	void GeometryPool::bind() const
+	{
+		glBindVertexArray(m_vao);
+	}
+	void GeometryPool::bindPositions() const
+	{
+		glBindVertexArray(m_positionVao != 0 ? m_positionVao : m_vao);
+	}
+	void GeometryPool::draw(const GeometryAllocation& allocation, DrawMode drawMode) const
+	{
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsBaseVertex(GL_TRIANGLES, allocation.numIndices, GL_UNSIGNED_INT,
+				(const void*)(sizeof(unsigned int) * (size_t)allocation.firstIndex), allocation.baseVertex);
+		}
+		else {
+			glDrawArrays(GL_POINTS, allocation.baseVertex, allocation.numVertices);
+		}
+	}
+	void GeometryPool::drawInstanced(const GeometryAllocation& allocation, int instanceCount, DrawMode drawMode) const
+	{
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, allocation.numIndices, GL_UNSIGNED_INT,
+				(const void*)(sizeof(unsigned int) * (size_t)allocation.firstIndex), instanceCount, allocation.baseVertex);
+		}
+		else {
+			glDrawArraysInstanced(GL_POINTS, allocation.baseVertex, allocation.numVertices, instanceCount);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <map>
+#include "mesh.h"
+
+namespace ew {
+	/// <summary>
+	/// First fit free list over a range of elements. Neighbouring free blocks are merged on release.
+	/// </summary>
+	class FreeListAllocator {
+	public:
+		FreeListAllocator() {};
+		FreeListAllocator(unsigned int capacity);
+		//Returns false if no free block is large enough
+		bool allocate(unsigned int size, unsigned int* offset);
+		void release(unsigned int offset, unsigned int size);
+		inline unsigned int getCapacity()const { return m_capacity; }
+		unsigned int getFreeSize()const;
+	private:
+		std::map<unsigned int, unsigned int> m_freeBlocks; //Offset -> size
+		unsigned int m_capacity = 0;
+	};
+
+	/// <summary>
+	/// One VAO, VBO and EBO shared by many meshes. Each mesh gets a vertex range and an index range,
+	/// and is drawn with glDrawElementsBaseVertex so its indices stay relative to its own vertices.
+	/// Bind once, then draw any number of allocations.
+	/// With positionStream, positions are also copied to a tightly packed buffer behind a second VAO, for depth only passes.
+	/// </summary>
+	class GeometryPool {
+	public:
+		GeometryPool(unsigned int maxVertices, unsigned int maxIndices, bool positionStream = false);
+		~GeometryPool();
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		//Copies meshData into the pool. Returns false if the pool is out of space
+		bool allocate(const MeshData& meshData, GeometryAllocation* allocation);
+		void release(const GeometryAllocation& allocation);
+
+		void bind()const;
+		//Binds the position only VAO, or the main one without a position stream. Draw calls are the same as after bind
+		void bindPositions()const;
+		//Expects the pool to be bound
+		void draw(const GeometryAllocation& allocation, DrawMode drawMode = DrawMode::TRIANGLES)const;
+		void drawInstanced(const GeometryAllocation& allocation, int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES)const;
+
+		inline unsigned int getVAO()const { return m_vao; }
+		inline bool hasPositionStream()const { return m_positionVao != 0; }
+		inline unsigned int getPositionVAO()const { return m_positionVao; }
+		inline unsigned int getVBO()const { return m_vbo; }
+		inline unsigned int getEBO()const { return m_ebo; }
+		inline unsigned int getFreeVertices()const { return m_vertexAllocator.getFreeSize(); }
+		inline unsigned int getFreeIndices()const { return m_indexAllocator.getFreeSize(); }
+	private:
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_positionVao = 0;
+		unsigned int m_positionVbo = 0;
+		FreeListAllocator m_vertexAllocator;
+		FreeListAllocator m_indexAllocator;
+	};
+}
@@ -0,0 +1,49 @@
+#include "glState.h"
+#include "external/glad.h"
+
+namespace ew {
+	void GLStateCache::useProgram(unsigned int program)
+	{
+		if (m_program == program) {
+			m_stats.programChangesAvoided++;
+			return;
+		}
+		glUseProgram(program);
+		m_program = program;
+		m_stats.programChanges++;
+	}
+	void GLStateCache::bindTexture2D(int unit, unsigned int texture)
+	{
+		if (m_textures[unit] == texture) {
+			m_stats.textureChangesAvoided++;
+			return;
+		}
+		if (m_activeUnit != unit) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+			m_activeUnit = unit;
+		}
+		glBindTexture(GL_TEXTURE_2D, texture);
+		m_textures[unit] = texture;
+		m_stats.textureChanges++;
+	}
+	void GLStateCache::bindVertexArray(unsigned int vao)
+	{
+		if (m_vao == vao) {
+			m_stats.vertexArrayChangesAvoided++;
+			return;
+		}
+		glBindVertexArray(vao);
+		m_vao = vao;
+		m_stats.vertexArrayChanges++;
+	}
+	void GLStateCache::invalidate()
+	{
+		m_program = -1;
+		m_vao = -1;
+		for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+		{
+			m_textures[i] = -1;
+		}
+		m_activeUnit = -1;
+	}
+}
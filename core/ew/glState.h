@@ -0,0 +1,37 @@
+#pragma once
+
+namespace ew {
+	/// <summary>
+	/// Shadows the GL binding state so redundant glUseProgram/glBindTexture/glBindVertexArray calls are skipped.
+	/// Only valid while every bind goes through the cache; call invalidate() after binding anything directly.
+	/// </summary>
+	class GLStateCache {
+	public:
+		static const int MAX_TEXTURE_UNITS = 16;
+
+		struct Stats {
+			unsigned int programChanges = 0;
+			unsigned int programChangesAvoided = 0;
+			unsigned int textureChanges = 0;
+			unsigned int textureChangesAvoided = 0;
+			unsigned int vertexArrayChanges = 0;
+			unsigned int vertexArrayChangesAvoided = 0;
+		};
+
+		void useProgram(unsigned int program);
+		void bindTexture2D(int unit, unsigned int texture);
+		void bindVertexArray(unsigned int vao);
+		//Forget what is bound, forcing the next call of each kind through to GL
+		void invalidate();
+
+		inline const Stats& getStats()const { return m_stats; }
+		inline void resetStats() { m_stats = Stats(); }
+	private:
+		//-1 means unknown
+		long long m_program = -1;
+		long long m_vao = -1;
+		long long m_textures[MAX_TEXTURE_UNITS] = { -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 };
+		int m_activeUnit = -1;
+		Stats m_stats;
+	};
+}
@@ -0,0 +1,48 @@
+#include "gpuTimer.h"
+#include "external/glad.h"
+
+namespace ew {
+	GpuTimer::GpuTimer()
+	{
+		glGenQueries(QUERY_COUNT, m_queries);
+		for (int i = 0; i < QUERY_COUNT; i++)
+			m_pending[i] = false;
+	}
+	GpuTimer::~GpuTimer()
+	{
+		glDeleteQueries(QUERY_COUNT, m_queries);
+	}
+	void GpuTimer::begin()
+	{
+		//Only blocks if the GPU is a whole ring of queries behind
+		if (m_pending[m_current])
+			collect(m_current);
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]);
+	}
+	void GpuTimer::end()
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_pending[m_current] = true;
+		m_current = (m_current + 1) % QUERY_COUNT;
+		//Oldest first, stopping at the first result that is not ready yet
+		for (int i = 0; i < QUERY_COUNT; i++)
+		{
+			int query = (m_current + i) % QUERY_COUNT;
+			if (!m_pending[query])
+				continue;
+			GLint available = 0;
+			glGetQueryObjectiv(m_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+			collect(query);
+		}
+	}
+	//Waits for the result if it is not available yet
+	void GpuTimer::collect(int query)
+	{
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(m_queries[query], GL_QUERY_RESULT, &nanoseconds);
+		m_milliseconds = (float)(nanoseconds / 1.0e6);
+		m_pending[query] = false;
+	}
+}
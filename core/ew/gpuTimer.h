@@ -0,0 +1,28 @@
+#pragma once
+
+namespace ew {
+	/// <summary>
+	/// Times GPU work between begin and end with GL_TIME_ELAPSED queries.
+	/// Results arrive a few frames late from a small ring of queries, so reading them never stalls the pipeline.
+	/// </summary>
+	class GpuTimer {
+	public:
+		GpuTimer();
+		~GpuTimer();
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		//Timer queries cannot nest, so only one GpuTimer may be running at a time
+		void begin();
+		void end();
+		//Most recent finished measurement
+		inline float getMilliseconds()const { return m_milliseconds; }
+	private:
+		static const int QUERY_COUNT = 4;
+		void collect(int query);
+		unsigned int m_queries[QUERY_COUNT];
+		bool m_pending[QUERY_COUNT];
+		int m_current = 0;
+		float m_milliseconds = 0.0f;
+	};
+}
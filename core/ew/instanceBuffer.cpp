@@ -0,0 +1,77 @@
+#include "instanceBuffer.h"
+#include <vector>
+#include "external/glad.h"
+
+namespace ew {
+	InstanceBuffer::~InstanceBuffer()
+	{
+		if (m_initialized) {
+			glDeleteBuffers(1, &m_modelVbo);
+			glDeleteBuffers(1, &m_colorVbo);
+		}
+	}
+	void InstanceBuffer::initialize()
+	{
+		glGenBuffers(1, &m_modelVbo);
+		glGenBuffers(1, &m_colorVbo);
+		m_initialized = true;
+	}
+	/// <summary>
+	/// Uploads per instance data. Reuses the existing storage when it is large enough.
+	/// </summary>
+	/// <param name="models">Array of count model matrices</param>
+	/// <param name="count">Number of instances</param>
+	/// <param name="colors">Optional array of count colors</param>
+	void InstanceBuffer::load(const ew::Mat4* models, int count, const ew::Vec4* colors)
+	{
+		if (!m_initialized) {
+			initialize();
+		}
+		bool grow = count > m_capacity;
+		glBindBuffer(GL_ARRAY_BUFFER, m_modelVbo);
+		if (grow) {
+			glBufferData(GL_ARRAY_BUFFER, sizeof(ew::Mat4) * count, models, GL_DYNAMIC_DRAW);
+		}
+		else if (count > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ew::Mat4) * count, models);
+		}
+		if (colors != NULL || grow) {
+			glBindBuffer(GL_ARRAY_BUFFER, m_colorVbo);
+			if (grow) {
+				//Instances without a color default to white
+				std::vector<ew::Vec4> white;
+				if (colors == NULL) {
+					white.resize(count, ew::Vec4(1.0f));
+					colors = white.data();
+				}
+				glBufferData(GL_ARRAY_BUFFER, sizeof(ew::Vec4) * count, colors, GL_DYNAMIC_DRAW);
+			}
+			else if (count > 0) {
+				glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ew::Vec4) * count, colors);
+			}
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if (grow) {
+			m_capacity = count;
+		}
+		m_count = count;
+	}
+	void InstanceBuffer::bindAttributes() const
+	{
+		//A mat4 attribute is 4 consecutive vec4 columns
+		glBindBuffer(GL_ARRAY_BUFFER, m_modelVbo);
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			glVertexAttribPointer(INSTANCE_MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(ew::Mat4), (const void*)(sizeof(ew::Vec4) * i));
+			glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + i);
+			glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + i, 1);
+		}
+		//Color attribute
+		glBindBuffer(GL_ARRAY_BUFFER, m_colorVbo);
+		glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(ew::Vec4), (const void*)0);
+		glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+		glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	//Vertex attribute locations read by instanced vertex shaders
+	const unsigned int INSTANCE_MODEL_LOCATION = 3; //mat4, occupies locations 3-6
+	const unsigned int INSTANCE_COLOR_LOCATION = 7; //vec4
+
+	/// <summary>
+	/// Per instance model matrices (and optional colors) stored as instanced vertex attributes.
+	/// Attach to a Mesh once, then update and draw with Mesh::drawInstanced.
+	/// The vertex shader reads the model matrix as an attribute, see assignment5's vertexShader.vert.
+	/// </summary>
+	class InstanceBuffer {
+	public:
+		InstanceBuffer() {};
+		~InstanceBuffer();
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+		//Uploads count instances. Colors may be NULL, in which case existing colors are kept
+		void load(const ew::Mat4* models, int count, const ew::Vec4* colors = NULL);
+		//Sets up the instanced attributes on the currently bound VAO. Requires load to have been called
+		void bindAttributes()const;
+		inline int getCount()const { return m_count; }
+	private:
+		void initialize();
+		bool m_initialized = false;
+		unsigned int m_modelVbo = 0;
+		unsigned int m_colorVbo = 0;
+		int m_count = 0;
+		int m_capacity = 0;
+	};
+}
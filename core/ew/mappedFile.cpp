@@ -0,0 +1,105 @@
+#include "mappedFile.h"
+#include <stdio.h>
+#include <errno.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <direct.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace ew {
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+#ifdef _WIN32
+	bool MappedFile::open(const char* path)
+	{
+		close();
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			CloseHandle(file);
+			return false;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_data = (const unsigned char*)view;
+		m_size = (size_t)size.QuadPart;
+		return true;
+	}
+	void MappedFile::close()
+	{
+		if (m_data != nullptr) {
+			UnmapViewOfFile(m_data);
+			CloseHandle((HANDLE)m_mapping);
+			CloseHandle((HANDLE)m_file);
+		}
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+	}
+	bool createDirectory(const char* path)
+	{
+		return _mkdir(path) == 0 || errno == EEXIST;
+	}
+#else
+	bool MappedFile::open(const char* path)
+	{
+		close();
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		//The mapping keeps its own reference to the file
+		::close(fd);
+		if (view == MAP_FAILED)
+			return false;
+		m_data = (const unsigned char*)view;
+		m_size = (size_t)info.st_size;
+		return true;
+	}
+	void MappedFile::close()
+	{
+		if (m_data != nullptr) {
+			munmap((void*)m_data, m_size);
+		}
+		m_data = nullptr;
+		m_size = 0;
+	}
+	bool createDirectory(const char* path)
+	{
+		return mkdir(path, 0755) == 0 || errno == EEXIST;
+	}
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+
+namespace ew {
+	/// <summary>
+	/// Read only memory mapping of a whole file (mmap, or MapViewOfFile on Windows).
+	/// The mapping stays valid until close or destruction.
+	/// </summary>
+	class MappedFile {
+	public:
+		MappedFile() {};
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const char* path);
+		void close();
+		inline bool isOpen()const { return m_data != nullptr; }
+		inline const unsigned char* getData()const { return m_data; }
+		inline size_t getSize()const { return m_size; }
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+	//Creates a single directory level. Returns true if it exists afterwards
+	bool createDirectory(const char* path);
+}
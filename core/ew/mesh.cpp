@@ -3,16 +3,167 @@
 */
 
 #include "mesh.h"
+#include "instanceBuffer.h"
+#include "geometryPool.h"
+#include "threadPool.h"
+#include "vertexPacking.h"
 #include "ewMath/ewMath.h"
 #include "external/glad.h"
+#include <mutex>
+#include <stdio.h>
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
+	void setVertexAttributes()
+	{
+		//Position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
+		glEnableVertexAttribArray(0);
+
+		//Normal attribute
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
+		glEnableVertexAttribArray(1);
+
+		//UV attribute
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
+		glEnableVertexAttribArray(2);
+	}
+	void setPositionAttributes()
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ew::Vec3), (const void*)0);
+		glEnableVertexAttribArray(0);
+	}
+	Bounds computeBounds(const std::vector<Vertex>& vertices)
+	{
+		Bounds bounds;
+		if (vertices.empty()) {
+			bounds.radius = 0.0f;
+			return bounds;
+		}
+		//Large generated meshes are split across the pool, each range merged under the lock
+		const size_t MIN_VERTICES_PER_RANGE = 1 << 16;
+		std::mutex mutex;
+		bounds.min = bounds.max = vertices[0].pos;
+		getThreadPool().parallelFor(vertices.size(), MIN_VERTICES_PER_RANGE, [&](size_t begin, size_t end) {
+			ew::Vec3 min = vertices[begin].pos, max = vertices[begin].pos;
+			for (size_t i = begin + 1; i < end; i++)
+			{
+				const ew::Vec3& p = vertices[i].pos;
+				min = ew::Vec3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+				max = ew::Vec3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			bounds.min = ew::Vec3(fminf(bounds.min.x, min.x), fminf(bounds.min.y, min.y), fminf(bounds.min.z, min.z));
+			bounds.max = ew::Vec3(fmaxf(bounds.max.x, max.x), fmaxf(bounds.max.y, max.y), fmaxf(bounds.max.z, max.z));
+		});
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+		float radiusSqr = 0.0f;
+		getThreadPool().parallelFor(vertices.size(), MIN_VERTICES_PER_RANGE, [&](size_t begin, size_t end) {
+			float rangeSqr = 0.0f;
+			for (size_t i = begin; i < end; i++)
+			{
+				ew::Vec3 d = vertices[i].pos - bounds.center;
+				rangeSqr = fmaxf(rangeSqr, ew::Dot(d, d));
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			radiusSqr = fmaxf(radiusSqr, rangeSqr);
+		});
+		bounds.radius = sqrtf(radiusSqr);
+		return bounds;
+	}
+	static_assert((int)IndexType::UINT16 == GL_UNSIGNED_SHORT && (int)IndexType::UINT32 == GL_UNSIGNED_INT, "IndexType must match the GL enums");
+
+	static MeshMemoryStats s_memoryStats;
+
+	const MeshMemoryStats& getMeshMemoryStats()
+	{
+		return s_memoryStats;
+	}
+	void printMeshMemoryReport()
+	{
+		const MeshMemoryStats& stats = s_memoryStats;
+		size_t uncompressed = stats.indexBytes + stats.indexBytesSaved;
+		printf("Mesh memory: vertices %zu KB, indices %zu KB (%zu KB as 32 bit, %zu KB saved)\n",
+			stats.vertexBytes / 1024, stats.indexBytes / 1024, uncompressed / 1024, stats.indexBytesSaved / 1024);
+	}
+	/// <summary>
+	/// Adds (sign = 1) or removes (sign = -1) this mesh's buffers from the memory stats
+	/// </summary>
+	void Mesh::trackMemory(int sign) const
+	{
+		size_t vertexBytes = (size_t)getVertexSize() * m_numVertices;
+		size_t indexBytes = (size_t)getIndexSize() * m_numIndices;
+		size_t saved = (size_t)(4 - getIndexSize()) * m_numIndices;
+		if (sign > 0) {
+			s_memoryStats.vertexBytes += vertexBytes;
+			s_memoryStats.indexBytes += indexBytes;
+			s_memoryStats.indexBytesSaved += saved;
+		}
+		else {
+			s_memoryStats.vertexBytes -= vertexBytes;
+			s_memoryStats.indexBytes -= indexBytes;
+			s_memoryStats.indexBytesSaved -= saved;
+		}
+	}
+	Mesh::Mesh(const MeshData& meshData, VertexFormat vertexFormat, bool positionStream)
+	{
+		load(meshData, vertexFormat, positionStream);
+	}
+	Mesh::Mesh(GeometryPool* pool, const MeshData& meshData)
+		:m_pool(pool)
 	{
 		load(meshData);
 	}
-	void Mesh::load(const MeshData& meshData)
+	void Mesh::load(const MeshData& meshData, VertexFormat vertexFormat, bool positionStream)
 	{
+		Bounds bounds = meshData.bounds.isValid() ? meshData.bounds : computeBounds(meshData.vertices);
+		if (m_pool != nullptr) {
+			if (m_initialized) {
+				trackMemory(-1);
+				m_pool->release(m_allocation);
+			}
+			m_bounds = bounds;
+			m_initialized = m_pool->allocate(meshData, &m_allocation);
+			if (!m_initialized) {
+				//The old range is already released and may belong to another mesh, so forget it
+				m_allocation = GeometryAllocation();
+				m_numVertices = 0;
+				m_numIndices = 0;
+				return;
+			}
+			m_vao = m_pool->getVAO();
+			m_positionVao = m_pool->getPositionVAO();
+			m_numVertices = m_allocation.numVertices;
+			m_numIndices = m_allocation.numIndices;
+			m_indexType = IndexType::UINT32;
+			m_vertexFormat = VertexFormat::FLOAT;
+			trackMemory(1);
+			return;
+		}
+		IndexType indexType = meshData.getIndexType();
+		const void* indexData = meshData.indices.data();
+		std::vector<unsigned short> shortIndices;
+		if (indexType == IndexType::UINT16) {
+			shortIndices.assign(meshData.indices.begin(), meshData.indices.end());
+			indexData = shortIndices.data();
+		}
+		if (vertexFormat == VertexFormat::PACKED) {
+			std::vector<PackedVertex> packed;
+			packVertices(meshData.vertices, bounds, &packed);
+			loadBuffers(packed.data(), (int)packed.size(), vertexFormat, indexData, (int)meshData.indices.size(), indexType, bounds);
+		}
+		else {
+			loadBuffers(meshData.vertices.data(), (int)meshData.vertices.size(), vertexFormat, indexData, (int)meshData.indices.size(), indexType, bounds);
+		}
+		if (positionStream) {
+			loadPositions(&meshData.vertices);
+		}
+	}
+	void Mesh::loadBuffers(const void* vertexData, int numVertices, VertexFormat vertexFormat, const void* indexData, int numIndices, IndexType indexType, const Bounds& bounds)
+	{
+		if (m_pool != nullptr) {
+			printf("Mesh::loadBuffers is not supported for pooled meshes\n");
+			return;
+		}
 		if (!m_initialized) {
 			glGenVertexArrays(1, &m_vao);
 			glBindVertexArray(m_vao);
@@ -22,47 +173,162 @@ namespace ew {
 
 			glGenBuffers(1, &m_ebo);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
-
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
-
-			//UV attribute
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
 
 			m_initialized = true;
 		}
+		else {
+			loadPositions(nullptr);
+			trackMemory(-1);
+		}
 
 		glBindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		m_bounds = bounds;
+		m_vertexFormat = vertexFormat;
+		m_indexType = indexType;
+		m_numVertices = numVertices;
+		m_numIndices = numIndices;
+		if (numVertices > 0) {
+			glBufferData(GL_ARRAY_BUFFER, (size_t)getVertexSize() * numVertices, vertexData, GL_STATIC_DRAW);
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		if (numIndices > 0) {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)getIndexSize() * numIndices, indexData, GL_STATIC_DRAW);
 		}
-		m_numVertices = meshData.vertices.size();
-		m_numIndices = meshData.indices.size();
+		if (m_vertexFormat == VertexFormat::PACKED) {
+			m_positionTransform = getDequantizeMatrix(m_bounds);
+			setPackedVertexAttributes();
+		}
+		else {
+			m_positionTransform = ew::IdentityMatrix();
+			setVertexAttributes();
+		}
+		trackMemory(1);
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
+	void Mesh::loadPositions(const std::vector<Vertex>* vertices)
+	{
+		if (m_positionVao != 0) {
+			glDeleteVertexArrays(1, &m_positionVao);
+			if (m_positionVbo != 0) {
+				glDeleteBuffers(1, &m_positionVbo);
+				s_memoryStats.vertexBytes -= sizeof(ew::Vec3) * (size_t)m_numVertices;
+			}
+			m_positionVao = 0;
+			m_positionVbo = 0;
+		}
+		if (vertices == nullptr)
+			return;
+		glGenVertexArrays(1, &m_positionVao);
+		glBindVertexArray(m_positionVao);
+		if (m_vertexFormat == VertexFormat::PACKED) {
+			//Already 16 bytes per vertex, and dequantizing a second copy could round differently. Read the main buffer
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, pos));
+			glEnableVertexAttribArray(0);
+		}
+		else {
+			std::vector<ew::Vec3> positions(vertices->size());
+			for (size_t i = 0; i < positions.size(); i++)
+				positions[i] = (*vertices)[i].pos;
+			glGenBuffers(1, &m_positionVbo);
+			glBindBuffer(GL_ARRAY_BUFFER, m_positionVbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(ew::Vec3) * positions.size(), positions.data(), GL_STATIC_DRAW);
+			setPositionAttributes();
+			s_memoryStats.vertexBytes += sizeof(ew::Vec3) * positions.size();
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	void Mesh::unload()
+	{
+		if (!m_initialized)
+			return;
+		trackMemory(-1);
+		if (m_pool != nullptr) {
+			m_pool->release(m_allocation);
+			m_allocation = GeometryAllocation();
+			m_positionVao = 0;
+		}
+		else {
+			loadPositions(nullptr);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteBuffers(1, &m_vbo);
+			glDeleteBuffers(1, &m_ebo);
+			m_vbo = 0;
+			m_ebo = 0;
+		}
+		m_vao = 0;
+		m_numVertices = 0;
+		m_numIndices = 0;
+		m_initialized = false;
+	}
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
+		if (!m_initialized)
+			return;
 		glBindVertexArray(m_vao);
+		drawUnbound(drawMode);
+	}
+	void Mesh::drawUnbound(ew::DrawMode drawMode) const
+	{
+		if (!m_initialized)
+			return;
+		if (m_pool != nullptr) {
+			m_pool->draw(m_allocation, drawMode);
+			return;
+		}
 		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+			glDrawElements(GL_TRIANGLES, m_numIndices, (GLenum)m_indexType, NULL);
 		}
 		else {
 			glDrawArrays(GL_POINTS, 0, m_numVertices);
 		}
-		
 	}
-}
\ No newline at end of file
+	void Mesh::drawPositions() const
+	{
+		if (!m_initialized)
+			return;
+		if (m_positionVao == 0) {
+			//Same positions through the full vertex layout
+			draw();
+			return;
+		}
+		if (m_pool != nullptr) {
+			m_pool->bindPositions();
+			m_pool->draw(m_allocation);
+			return;
+		}
+		glBindVertexArray(m_positionVao);
+		glDrawElements(GL_TRIANGLES, m_numIndices, (GLenum)m_indexType, NULL);
+	}
+	void Mesh::drawInstanced(int instanceCount, ew::DrawMode drawMode) const
+	{
+		if (!m_initialized)
+			return;
+		if (m_pool != nullptr) {
+			m_pool->bind();
+			m_pool->drawInstanced(m_allocation, instanceCount, drawMode);
+			return;
+		}
+		glBindVertexArray(m_vao);
+		if (drawMode == DrawMode::TRIANGLES) {
+			glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, (GLenum)m_indexType, NULL, instanceCount);
+		}
+		else {
+			glDrawArraysInstanced(GL_POINTS, 0, m_numVertices, instanceCount);
+		}
+	}
+	void Mesh::attachInstanceBuffer(const InstanceBuffer& instanceBuffer) const
+	{
+		glBindVertexArray(m_vao);
+		instanceBuffer.bindAttributes();
+		glBindVertexArray(0);
+	}
+}
@@ -12,9 +12,36 @@ namespace ew {
 		ew::Vec2 uv;
 	};
 
+	//Local space axis aligned box plus a sphere centered on it
+	struct Bounds {
+		ew::Vec3 min = ew::Vec3(0);
+		ew::Vec3 max = ew::Vec3(0);
+		ew::Vec3 center = ew::Vec3(0);
+		float radius = -1.0f; //Negative until computed
+		inline bool isValid()const { return radius >= 0.0f; }
+	};
+
+	//Index formats a Mesh can upload. Values match the GL enums
+	enum class IndexType {
+		UINT16 = 0x1403, //GL_UNSIGNED_SHORT
+		UINT32 = 0x1405 //GL_UNSIGNED_INT
+	};
+
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		Bounds bounds;
+
+		//Format Mesh::load uploads. 0xFFFF is left unused so it stays free for primitive restart
+		inline IndexType getIndexType()const { return vertices.size() < 0xFFFF ? IndexType::UINT16 : IndexType::UINT32; }
+	};
+
+	//Box around every vertex, and the smallest sphere around them that shares the box center
+	Bounds computeBounds(const std::vector<Vertex>& vertices);
+
+	enum class VertexFormat {
+		FLOAT = 0, //ew::Vertex, 32 bytes
+		PACKED = 1 //ew::PackedVertex, 16 bytes. See vertexPacking.h
 	};
 
 	enum class DrawMode {
@@ -22,20 +49,92 @@ namespace ew {
 		POINTS = 1
 	};
 
+	//Range of vertices and indices suballocated from a GeometryPool
+	struct GeometryAllocation {
+		unsigned int baseVertex = 0;
+		unsigned int numVertices = 0;
+		unsigned int firstIndex = 0;
+		unsigned int numIndices = 0;
+	};
+
+	//GPU buffer memory held by every loaded Mesh
+	struct MeshMemoryStats {
+		size_t vertexBytes = 0;
+		size_t indexBytes = 0;
+		//Index bytes avoided by 16 bit indices, compared to uploading everything as 32 bit
+		size_t indexBytesSaved = 0;
+	};
+	const MeshMemoryStats& getMeshMemoryStats();
+	void printMeshMemoryReport();
+
+	class InstanceBuffer;
+	class GeometryPool;
+
+	//Sets up the ew::Vertex attribute layout for the bound VAO and GL_ARRAY_BUFFER
+	void setVertexAttributes();
+	//Sets up a tightly packed vec3 position at location 0, the only input of depth only passes
+	void setPositionAttributes();
+
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
-		void load(const MeshData& meshData);
+		Mesh(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::FLOAT, bool positionStream = false);
+		//Lightweight handle into a shared pool instead of owning a VAO/VBO/EBO
+		Mesh(GeometryPool* pool, const MeshData& meshData);
+		//Pooled meshes always use VertexFormat::FLOAT, the pool's layout, and have a position stream if the pool does.
+		//positionStream adds a second VAO that reads positions only, from their own tightly packed buffer (see drawPositions)
+		void load(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::FLOAT, bool positionStream = false);
+		//Uploads buffers that are already in their final format, e.g. straight from a mapped mesh file.
+		//vertexData must hold numVertices vertices of vertexFormat and bounds must be the bounds they were packed against.
+		//Drops the position stream
+		void loadBuffers(const void* vertexData, int numVertices, VertexFormat vertexFormat, const void* indexData, int numIndices, IndexType indexType, const Bounds& bounds);
+		//Deletes the VAO and buffers, or releases the pool allocation. Copies of this Mesh share them and must not be drawn afterwards
+		void unload();
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Issues the draw call without binding, for callers that track the bound VAO themselves
+		void drawUnbound(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Draws through the position stream's VAO, for depth pre-passes and shadow maps.
+		//Positions are bit identical to the main stream's, so a later pass with GL_EQUAL depth testing matches them exactly
+		//as long as both vertex shaders compute gl_Position the same way and declare it invariant
+		void drawPositions()const;
+		//Draws instanceCount copies in one call. Per instance data comes from an attached InstanceBuffer
+		void drawInstanced(int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Adds the buffer's per instance attributes to this mesh's VAO.
+		//For pooled meshes this is the pool's shared VAO
+		void attachInstanceBuffer(const InstanceBuffer& instanceBuffer)const;
+		inline bool isPooled()const { return m_pool != nullptr; }
+		inline const GeometryAllocation& getAllocation()const { return m_allocation; }
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		inline unsigned int getVAO()const { return m_vao; }
+		inline bool hasPositionStream()const { return m_positionVao != 0; }
+		//Position only VAO sharing this mesh's index buffer. For pooled meshes it is the pool's
+		inline unsigned int getPositionVAO()const { return m_positionVao; }
+		inline const Bounds& getBounds()const { return m_bounds; }
+		//Pooled meshes always use 32 bit indices so one multi-draw call covers the whole pool
+		inline IndexType getIndexType()const { return m_indexType; }
+		inline int getIndexSize()const { return m_indexType == IndexType::UINT16 ? 2 : 4; }
+		inline VertexFormat getVertexFormat()const { return m_vertexFormat; }
+		inline int getVertexSize()const { return m_vertexFormat == VertexFormat::PACKED ? 16 : (int)sizeof(Vertex); }
+		//Maps vertex positions to mesh space. Identity unless packed, in which case it must be applied before the model matrix
+		inline const ew::Mat4& getPositionTransform()const { return m_positionTransform; }
 	private:
+		void trackMemory(int sign)const;
+		//Creates the position stream from vertices, or deletes it when vertices is null
+		void loadPositions(const std::vector<Vertex>* vertices);
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
+		unsigned int m_positionVao = 0;
+		unsigned int m_positionVbo = 0; //Zero for packed meshes, whose position VAO reads the main buffer
 		int m_numVertices = 0;
 		int m_numIndices = 0;
+		GeometryPool* m_pool = nullptr;
+		GeometryAllocation m_allocation;
+		Bounds m_bounds;
+		IndexType m_indexType = IndexType::UINT32;
+		VertexFormat m_vertexFormat = VertexFormat::FLOAT;
+		ew::Mat4 m_positionTransform = ew::IdentityMatrix();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "meshCache.h"
+#include "mappedFile.h"
+#include "vertexPacking.h"
+#include "procGen.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+
+namespace ew {
+	namespace {
+		inline uint64_t alignUp(uint64_t value) {
+			return (value + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+		}
+		inline uint32_t getStride(VertexFormat vertexFormat) {
+			return vertexFormat == VertexFormat::PACKED ? (uint32_t)sizeof(PackedVertex) : (uint32_t)sizeof(Vertex);
+		}
+		inline uint32_t getIndexSize(IndexType indexType) {
+			return indexType == IndexType::UINT16 ? 2 : 4;
+		}
+		//True if count elements of stride bytes starting at offset lie inside a file of fileSize bytes, and count fits in an int.
+		//Divides instead of multiplying so corrupt counts cannot wrap around
+		inline bool blobFits(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize) {
+			return offset <= fileSize && count <= (fileSize - offset) / stride && count <= (uint64_t)INT_MAX;
+		}
+		//Checks the header and that both blobs lie inside the file
+		const MeshFileHeader* validateHeader(const MappedFile& file, const std::string& path) {
+			if (file.getSize() < sizeof(MeshFileHeader)) {
+				printf("Mesh file %s is truncated\n", path.c_str());
+				return NULL;
+			}
+			const MeshFileHeader* header = (const MeshFileHeader*)file.getData();
+			if (header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION) {
+				printf("Mesh file %s has an unknown format or version\n", path.c_str());
+				return NULL;
+			}
+			VertexFormat vertexFormat = (VertexFormat)header->vertexFormat;
+			IndexType indexType = (IndexType)header->indexType;
+			if ((vertexFormat != VertexFormat::FLOAT && vertexFormat != VertexFormat::PACKED) || header->vertexStride != getStride(vertexFormat)
+				|| (indexType != IndexType::UINT16 && indexType != IndexType::UINT32)) {
+				printf("Mesh file %s has an unsupported vertex or index layout\n", path.c_str());
+				return NULL;
+			}
+			if (!blobFits(header->vertexOffset, header->numVertices, header->vertexStride, file.getSize())
+				|| !blobFits(header->indexOffset, header->numIndices, getIndexSize(indexType), file.getSize())) {
+				printf("Mesh file %s is truncated\n", path.c_str());
+				return NULL;
+			}
+			return header;
+		}
+		uint32_t hashBytes(uint32_t hash, const void* data, size_t size) {
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ bytes[i]) * 16777619u;
+			}
+			return hash;
+		}
+		uint32_t hashMeshData(const MeshData& meshData) {
+			uint32_t hash = hashBytes(2166136261u, meshData.vertices.data(), meshData.vertices.size() * sizeof(Vertex));
+			return hashBytes(hash, meshData.indices.data(), meshData.indices.size() * sizeof(unsigned int));
+		}
+		Bounds readBounds(const MeshFileHeader& header) {
+			Bounds bounds;
+			bounds.min = ew::Vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+			bounds.max = ew::Vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+			bounds.center = ew::Vec3(header.boundsCenter[0], header.boundsCenter[1], header.boundsCenter[2]);
+			bounds.radius = header.boundsRadius;
+			return bounds;
+		}
+	}
+
+	bool writeMeshFile(const std::string& path, const MeshData& meshData, VertexFormat vertexFormat)
+	{
+		Bounds bounds = meshData.bounds.isValid() ? meshData.bounds : computeBounds(meshData.vertices);
+		IndexType indexType = meshData.getIndexType();
+
+		MeshFileHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = MESH_FILE_MAGIC;
+		header.version = MESH_FILE_VERSION;
+		header.vertexFormat = (uint32_t)vertexFormat;
+		header.vertexStride = getStride(vertexFormat);
+		header.indexType = (uint32_t)indexType;
+		header.contentHash = hashMeshData(meshData);
+		header.numVertices = meshData.vertices.size();
+		header.numIndices = meshData.indices.size();
+		header.vertexOffset = alignUp(sizeof(MeshFileHeader));
+		header.indexOffset = alignUp(header.vertexOffset + header.numVertices * header.vertexStride);
+		memcpy(header.boundsMin, &bounds.min.x, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, &bounds.max.x, sizeof(header.boundsMax));
+		memcpy(header.boundsCenter, &bounds.center.x, sizeof(header.boundsCenter));
+		header.boundsRadius = bounds.radius;
+
+		//Assembled in memory so the file is written with a single fwrite
+		std::vector<unsigned char> blob(header.indexOffset + header.numIndices * getIndexSize(indexType), 0);
+		memcpy(blob.data(), &header, sizeof(header));
+		if (vertexFormat == VertexFormat::PACKED) {
+			std::vector<PackedVertex> packed;
+			packVertices(meshData.vertices, bounds, &packed);
+			memcpy(blob.data() + header.vertexOffset, packed.data(), packed.size() * sizeof(PackedVertex));
+		}
+		else if (!meshData.vertices.empty()) {
+			memcpy(blob.data() + header.vertexOffset, meshData.vertices.data(), meshData.vertices.size() * sizeof(Vertex));
+		}
+		if (indexType == IndexType::UINT16) {
+			uint16_t* dst = (uint16_t*)(blob.data() + header.indexOffset);
+			for (size_t i = 0; i < meshData.indices.size(); i++)
+			{
+				dst[i] = (uint16_t)meshData.indices[i];
+			}
+		}
+		else if (!meshData.indices.empty()) {
+			memcpy(blob.data() + header.indexOffset, meshData.indices.data(), meshData.indices.size() * sizeof(unsigned int));
+		}
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == NULL) {
+			printf("Failed to open %s for writing\n", path.c_str());
+			return false;
+		}
+		bool written = fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+		fclose(file);
+		if (!written) {
+			printf("Failed to write %s\n", path.c_str());
+			remove(path.c_str());
+		}
+		return written;
+	}
+	bool readMeshFile(const std::string& path, MeshData* meshData)
+	{
+		MappedFile file;
+		if (!file.open(path.c_str()))
+			return false;
+		const MeshFileHeader* header = validateHeader(file, path);
+		if (header == NULL)
+			return false;
+		if ((VertexFormat)header->vertexFormat != VertexFormat::FLOAT) {
+			printf("Mesh file %s is packed and can only be uploaded with loadMeshFile\n", path.c_str());
+			return false;
+		}
+		const Vertex* vertices = (const Vertex*)(file.getData() + header->vertexOffset);
+		meshData->vertices.assign(vertices, vertices + header->numVertices);
+		meshData->indices.resize(header->numIndices);
+		const unsigned char* indices = file.getData() + header->indexOffset;
+		if ((IndexType)header->indexType == IndexType::UINT16) {
+			for (size_t i = 0; i < header->numIndices; i++)
+			{
+				meshData->indices[i] = ((const uint16_t*)indices)[i];
+			}
+		}
+		else {
+			memcpy(meshData->indices.data(), indices, header->numIndices * sizeof(unsigned int));
+		}
+		meshData->bounds = readBounds(*header);
+		return true;
+	}
+	bool loadMeshFile(const std::string& path, Mesh* mesh)
+	{
+		if (mesh->isPooled()) {
+			MeshData meshData;
+			if (!readMeshFile(path, &meshData))
+				return false;
+			mesh->load(meshData);
+			return true;
+		}
+		MappedFile file;
+		if (!file.open(path.c_str()))
+			return false;
+		const MeshFileHeader* header = validateHeader(file, path);
+		if (header == NULL)
+			return false;
+		//glBufferData copies out of the mapping, so it can be closed as soon as this returns
+		mesh->loadBuffers(file.getData() + header->vertexOffset, (int)header->numVertices, (VertexFormat)header->vertexFormat,
+			file.getData() + header->indexOffset, (int)header->numIndices, (IndexType)header->indexType, readBounds(*header));
+		return true;
+	}
+
+	MeshCache::MeshCache(const std::string& directory)
+		:m_directory(directory)
+	{
+	}
+	std::string MeshCache::makeKey(const char* generator, std::initializer_list<float> params)
+	{
+		std::string key = generator;
+		char buffer[32];
+		for (float param : params)
+		{
+			snprintf(buffer, sizeof(buffer), "_%g", param);
+			key += buffer;
+		}
+		return key;
+	}
+	std::string MeshCache::getPath(const std::string& key, VertexFormat vertexFormat) const
+	{
+		//e.g. sphere_0.5_64.v1.opt.packed.ewmesh. A different generator version or optimize setting never maps this file
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".v%u%s", PROC_GEN_VERSION, getOptimizeGeneratedMeshes() ? ".opt" : "");
+		return m_directory + "/" + key + suffix + (vertexFormat == VertexFormat::PACKED ? ".packed.ewmesh" : ".ewmesh");
+	}
+	bool MeshCache::load(Mesh* mesh, const std::string& key, const std::function<MeshData()>& generate, VertexFormat vertexFormat)
+	{
+		//Pooled meshes need a FLOAT file to read back into MeshData
+		if (mesh->isPooled()) {
+			vertexFormat = VertexFormat::FLOAT;
+		}
+		std::string path = getPath(key, vertexFormat);
+		if (loadMeshFile(path, mesh)) {
+			m_hits++;
+#ifndef NDEBUG
+			//Catches a generator change that PROC_GEN_VERSION was not bumped for
+			MeshData generated = generate();
+			MappedFile file;
+			if (file.open(path.c_str()) && ((const MeshFileHeader*)file.getData())->contentHash != hashMeshData(generated)) {
+				printf("Cached mesh %s no longer matches its generator, bump ew::PROC_GEN_VERSION\n", path.c_str());
+				file.close();
+				writeMeshFile(path, generated, vertexFormat);
+				mesh->load(generated, vertexFormat);
+			}
+#endif
+			return true;
+		}
+		m_misses++;
+		MeshData meshData = generate();
+		createDirectory(m_directory.c_str());
+		writeMeshFile(path, meshData, vertexFormat);
+		mesh->load(meshData, vertexFormat);
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <initializer_list>
+#include <stdint.h>
+#include "mesh.h"
+
+namespace ew {
+	const uint32_t MESH_FILE_MAGIC = 0x534D5745; //"EWMS"
+	//Bump whenever the file layout changes. Generator changes bump PROC_GEN_VERSION instead
+	const uint32_t MESH_FILE_VERSION = 2;
+	//Vertex and index blobs start on this boundary
+	const size_t MESH_FILE_ALIGNMENT = 64;
+
+	/// <summary>
+	/// Start of a .ewmesh file. The vertex blob is stored in vertexFormat and the index blob in indexType,
+	/// exactly as they are uploaded, so a mapped file can be handed straight to glBufferData.
+	/// </summary>
+	struct MeshFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexFormat; //ew::VertexFormat
+		uint32_t vertexStride;
+		uint32_t indexType; //ew::IndexType, the GL enum
+		uint32_t contentHash; //FNV-1a of the FLOAT vertices and indices the file was written from
+		uint64_t numVertices;
+		uint64_t numIndices;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		float boundsMin[3];
+		float boundsMax[3];
+		float boundsCenter[3];
+		float boundsRadius;
+	};
+
+	bool writeMeshFile(const std::string& path, const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::FLOAT);
+	//Copies a FLOAT format file into meshData, for pooled meshes or further processing
+	bool readMeshFile(const std::string& path, MeshData* meshData);
+	//Maps the file and uploads straight from the mapping. Pooled meshes are read with readMeshFile instead
+	bool loadMeshFile(const std::string& path, Mesh* mesh);
+
+	/// <summary>
+	/// Directory of generated meshes keyed by generator parameters. A miss runs the generator and writes the file,
+	/// a hit only maps the file. File names also carry PROC_GEN_VERSION and whether generated meshes are optimized.
+	/// Debug builds run the generator on a hit as well and rewrite the file if its contentHash no longer matches.
+	/// </summary>
+	class MeshCache {
+	public:
+		MeshCache(const std::string& directory = "meshCache");
+		//e.g. makeKey("sphere", { 0.5f, 64 }) -> "sphere_0.5_64"
+		static std::string makeKey(const char* generator, std::initializer_list<float> params);
+		bool load(Mesh* mesh, const std::string& key, const std::function<MeshData()>& generate, VertexFormat vertexFormat = VertexFormat::FLOAT);
+		inline int getHits()const { return m_hits; }
+		inline int getMisses()const { return m_misses; }
+	private:
+		std::string getPath(const std::string& key, VertexFormat vertexFormat)const;
+		std::string m_directory;
+		int m_hits = 0;
+		int m_misses = 0;
+	};
+}
@@ -0,0 +1,90 @@
+#include "meshLOD.h"
+#include "meshSimplify.h"
+#include <math.h>
+#include <algorithm>
+
+namespace ew {
+	MeshLOD::MeshLOD(const std::function<MeshData(int)>& generator, const std::vector<int>& subdivisions, GeometryPool* pool)
+		:m_subdivisions(subdivisions)
+	{
+		m_levels.reserve(subdivisions.size());
+		for (size_t i = 0; i < subdivisions.size(); i++)
+		{
+			if (pool != NULL) {
+				m_levels.emplace_back(pool, generator(subdivisions[i]));
+			}
+			else {
+				m_levels.emplace_back(generator(subdivisions[i]));
+			}
+		}
+	}
+	MeshLOD::MeshLOD(const MeshData& source, const std::vector<float>& ratios, GeometryPool* pool)
+	{
+		m_levels.reserve(ratios.size());
+		for (size_t i = 0; i < ratios.size(); i++)
+		{
+			MeshData level;
+			if (ratios[i] >= 1.0f) {
+				level = source;
+			}
+			else {
+				SimplifyOptions options;
+				options.targetRatio = ratios[i];
+				level = simplifyMesh(source, options);
+			}
+			//A sphere of s subdivisions has about 2 * s * s triangles
+			m_subdivisions.push_back((int)sqrtf(level.indices.size() / 3 * 0.5f));
+			if (pool != NULL) {
+				m_levels.emplace_back(pool, level);
+			}
+			else {
+				m_levels.emplace_back(level);
+			}
+		}
+	}
+	float MeshLOD::projectedRadius(const Camera& camera, float viewportHeight, const ew::Vec3& worldCenter, float worldRadius)
+	{
+		if (camera.orthographic) {
+			return worldRadius / (camera.orthoHeight * 0.5f) * viewportHeight * 0.5f;
+		}
+		float distance = ew::Magnitude(worldCenter - camera.position);
+		//Camera inside the sphere, treat it as filling the screen
+		if (distance <= worldRadius)
+			return viewportHeight;
+		float halfFovTan = tanf(ew::Radians(camera.fov) * 0.5f);
+		return worldRadius / (distance * halfFovTan) * viewportHeight * 0.5f;
+	}
+	/// <summary>
+	/// A ring of s segments around a sphere of r pixels has edges 2 * PI * r / s pixels long
+	/// </summary>
+	int MeshLOD::levelForRadius(float pixelRadius) const
+	{
+		float requiredSegments = ew::TAU * pixelRadius / edgePixels;
+		int level = 0;
+		for (int i = 1; i < (int)m_subdivisions.size(); i++)
+		{
+			if ((float)m_subdivisions[i] < requiredSegments)
+				break;
+			level = i;
+		}
+		return level;
+	}
+	int MeshLOD::selectLevel(const Camera& camera, float viewportHeight, const ew::Vec3& worldCenter, float worldRadius, int* level) const
+	{
+		float radius = projectedRadius(camera, viewportHeight, worldCenter, worldRadius);
+		int current = *level;
+		if (current < 0 || current >= getNumLevels()) {
+			current = levelForRadius(radius);
+		}
+		int target = levelForRadius(radius);
+		if (target > current) {
+			//Coarser only once the object is clearly smaller than the threshold
+			target = std::max(current, levelForRadius(radius * (1.0f + hysteresis)));
+		}
+		else if (target < current) {
+			target = std::min(current, levelForRadius(radius * (1.0f - hysteresis)));
+		}
+		*level = target;
+		return target;
+	}
+}
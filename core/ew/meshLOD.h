@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include "mesh.h"
+#include "camera.h"
+
+namespace ew {
+	/// <summary>
+	/// Chain of meshes generated at decreasing subdivision counts. Level 0 is the most detailed.
+	/// Each object drawn with the chain keeps its own current level so hysteresis works per object.
+	/// </summary>
+	class MeshLOD {
+	public:
+		//generator is called once per subdivision count, e.g. [](int s) { return ew::createSphere(0.5f, s); }
+		//subdivisions must be in decreasing order. pool may be NULL for standalone meshes
+		MeshLOD(const std::function<MeshData(int)>& generator, const std::vector<int>& subdivisions = { 64, 32, 16, 8 }, GeometryPool* pool = NULL);
+		//Builds the chain by simplifying source to each ratio of its triangles, e.g. { 1.0f, 0.5f, 0.25f, 0.125f }.
+		//Levels are treated like spheres with the same triangle count when selecting
+		MeshLOD(const MeshData& source, const std::vector<float>& ratios, GeometryPool* pool = NULL);
+		MeshLOD(const MeshLOD&) = delete;
+		MeshLOD& operator=(const MeshLOD&) = delete;
+
+		//Radius in pixels of a world space sphere, using the camera's FOV (or ortho height) and distance
+		static float projectedRadius(const Camera& camera, float viewportHeight, const ew::Vec3& worldCenter, float worldRadius);
+		//Updates level for an object with the given world space bounding sphere and returns it.
+		//A level only changes once the ideal level is still different after moving the radius by the hysteresis fraction
+		int selectLevel(const Camera& camera, float viewportHeight, const ew::Vec3& worldCenter, float worldRadius, int* level)const;
+		//Coarsest level whose triangle edges are no longer than edgePixels on screen
+		int levelForRadius(float pixelRadius)const;
+
+		inline const Mesh& getLevel(int level)const { return m_levels[level]; }
+		inline int getNumLevels()const { return (int)m_levels.size(); }
+		inline int getSubdivisions(int level)const { return m_subdivisions[level]; }
+		//Level 0 bounds, which contain every coarser level closely enough for culling
+		inline const Bounds& getBounds()const { return m_levels[0].getBounds(); }
+
+		//Target on screen edge length in pixels
+		float edgePixels = 8.0f;
+		//Fraction the projected radius must move past a threshold before switching
+		float hysteresis = 0.15f;
+	private:
+		std::vector<Mesh> m_levels;
+		std::vector<int> m_subdivisions;
+	};
+}
@@ -0,0 +1,163 @@
+#include "meshOptimizer.h"
+#include <vector>
+
+namespace ew {
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, int cacheSize)
+	{
+		VertexCacheStats stats;
+		size_t numTriangles = meshData.indices.size() / 3;
+		if (numTriangles == 0)
+			return stats;
+		//Each vertex remembers the miss count when it entered the cache, so membership is a subtraction
+		std::vector<unsigned int> entered(meshData.vertices.size(), 0);
+		std::vector<bool> used(meshData.vertices.size(), false);
+		unsigned int misses = 0;
+		size_t uniqueVertices = 0;
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			unsigned int v = meshData.indices[i];
+			if (!used[v]) {
+				used[v] = true;
+				uniqueVertices++;
+			}
+			else if (misses - entered[v] < (unsigned int)cacheSize) {
+				continue;
+			}
+			misses++;
+			entered[v] = misses;
+		}
+		stats.acmr = (float)misses / numTriangles;
+		stats.atvr = (float)misses / uniqueVertices;
+		return stats;
+	}
+
+	/// <summary>
+	/// Tipsify (Sander, Nehab and Barczak 2007). Fans out around a vertex, then moves to the neighbour that is
+	/// still in the cache and will not be evicted before its remaining triangles are emitted.
+	/// </summary>
+	void optimizeVertexCache(MeshData* meshData, int cacheSize)
+	{
+		std::vector<unsigned int>& indices = meshData->indices;
+		size_t numTriangles = indices.size() / 3;
+		size_t numVertices = meshData->vertices.size();
+		if (numTriangles == 0)
+			return;
+
+		//Vertex to triangle adjacency, stored compactly: triangles of v are adjacency[offsets[v]..offsets[v+1])
+		std::vector<unsigned int> liveTriangles(numVertices, 0);
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			liveTriangles[indices[i]]++;
+		}
+		std::vector<unsigned int> offsets(numVertices + 1, 0);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			offsets[v + 1] = offsets[v] + liveTriangles[v];
+		}
+		std::vector<unsigned int> adjacency(numTriangles * 3);
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+
+		std::vector<unsigned int> cacheTime(numVertices, 0);
+		std::vector<bool> emitted(numTriangles, false);
+		std::vector<unsigned int> deadEnds;
+		std::vector<unsigned int> candidates;
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+		unsigned int time = cacheSize + 1;
+		size_t cursor = 0;
+
+		//Most recently touched vertex with triangles left, else the next one in input order
+		auto skipDeadEnd = [&]() -> int {
+			while (!deadEnds.empty()) {
+				unsigned int d = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[d] > 0)
+					return (int)d;
+			}
+			for (; cursor < numVertices; cursor++)
+			{
+				if (liveTriangles[cursor] > 0)
+					return (int)cursor;
+			}
+			return -1;
+		};
+
+		int fanning = skipDeadEnd();
+		while (fanning >= 0) {
+			candidates.clear();
+			for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+			{
+				unsigned int t = adjacency[a];
+				if (emitted[t])
+					continue;
+				emitted[t] = true;
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = indices[t * 3 + k];
+					output.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - cacheTime[v] > (unsigned int)cacheSize) {
+						cacheTime[v] = time;
+						time++;
+					}
+				}
+			}
+			//Prefer the candidate that entered the cache earliest but will still be there after its fan
+			int best = -1;
+			int bestPriority = -1;
+			for (unsigned int v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+					continue;
+				int priority = 0;
+				if ((int)(time - cacheTime[v]) + 2 * (int)liveTriangles[v] <= cacheSize) {
+					priority = (int)(time - cacheTime[v]);
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					best = (int)v;
+				}
+			}
+			fanning = best >= 0 ? best : skipDeadEnd();
+		}
+		indices.swap(output);
+	}
+
+	void optimizeVertexFetch(MeshData* meshData)
+	{
+		const unsigned int UNUSED = 0xFFFFFFFF;
+		std::vector<unsigned int> remap(meshData->vertices.size(), UNUSED);
+		std::vector<Vertex> vertices;
+		vertices.reserve(meshData->vertices.size());
+		for (unsigned int& index : meshData->indices)
+		{
+			if (remap[index] == UNUSED) {
+				remap[index] = (unsigned int)vertices.size();
+				vertices.push_back(meshData->vertices[index]);
+			}
+			index = remap[index];
+		}
+		meshData->vertices.swap(vertices);
+	}
+
+	MeshOptimizeReport optimizeMesh(MeshData* meshData)
+	{
+		MeshOptimizeReport report;
+		report.before = analyzeVertexCache(*meshData);
+		//Strips that are already cache friendly (cylinder sides) can come out slightly worse, so keep the better order
+		std::vector<unsigned int> original = meshData->indices;
+		optimizeVertexCache(meshData);
+		if (analyzeVertexCache(*meshData).acmr > report.before.acmr) {
+			meshData->indices.swap(original);
+		}
+		optimizeVertexFetch(meshData);
+		report.after = analyzeVertexCache(*meshData);
+		return report;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Post transform cache size assumed by the optimizer and the simulator
+	const int DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	//Results of simulating a FIFO post transform vertex cache
+	struct VertexCacheStats {
+		//Average cache miss ratio: vertex shader invocations per triangle. 0.5 is ideal for large grids, 3 is worst
+		float acmr = 0.0f;
+		//Average transform to vertex ratio: invocations per referenced vertex. 1 is ideal
+		float atvr = 0.0f;
+	};
+
+	struct MeshOptimizeReport {
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	VertexCacheStats analyzeVertexCache(const MeshData& meshData, int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+	//Reorders triangles for post transform cache reuse (Tipsify). The triangles themselves are unchanged
+	void optimizeVertexCache(MeshData* meshData, int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+	//Reorders vertices into first use order so fetches walk memory linearly. Unreferenced vertices are removed
+	void optimizeVertexFetch(MeshData* meshData);
+	//Runs both passes and measures the cache before and after
+	MeshOptimizeReport optimizeMesh(MeshData* meshData);
+}
@@ -0,0 +1,408 @@
+#include "meshSimplify.h"
+#include "meshOptimizer.h"
+#include "threadPool.h"
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <math.h>
+#include <stdint.h>
+
+namespace ew {
+	namespace {
+		//Sum of squared distances to a set of planes, as the upper triangle of a symmetric 4x4 matrix
+		struct Quadric {
+			double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+			double a11 = 0, a12 = 0, a13 = 0;
+			double a22 = 0, a23 = 0;
+			double a33 = 0;
+
+			void addPlane(double a, double b, double c, double d) {
+				a00 += a * a; a01 += a * b; a02 += a * c; a03 += a * d;
+				a11 += b * b; a12 += b * c; a13 += b * d;
+				a22 += c * c; a23 += c * d;
+				a33 += d * d;
+			}
+			void add(const Quadric& q) {
+				a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+				a11 += q.a11; a12 += q.a12; a13 += q.a13;
+				a22 += q.a22; a23 += q.a23;
+				a33 += q.a33;
+			}
+			double evaluate(const ew::Vec3& p)const {
+				double x = p.x, y = p.y, z = p.z;
+				return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+					+ a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+					+ a22 * z * z + 2 * a23 * z
+					+ a33;
+			}
+		};
+
+		struct Collapse {
+			float cost;
+			uint32_t from;
+			uint32_t to;
+			uint32_t version;
+			bool operator>(const Collapse& other)const { return cost > other.cost; }
+		};
+
+		const uint32_t NO_CLUSTER = 0xFFFFFFFF;
+
+		/// <summary>
+		/// Vertices that must not move: any vertex sharing its position with another vertex (UV seams, hard normal edges)
+		/// and vertices on open or non-manifold edges. Edges are compared by position so seams do not count as boundaries.
+		/// </summary>
+		std::vector<uint8_t> findAttributeLockedVertices(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& corners) {
+			size_t numVertices = vertices.size();
+			std::vector<uint32_t> order(numVertices);
+			for (uint32_t i = 0; i < numVertices; i++)
+			{
+				order[i] = i;
+			}
+			auto lessPosition = [&](uint32_t a, uint32_t b) {
+				const ew::Vec3& pa = vertices[a].pos;
+				const ew::Vec3& pb = vertices[b].pos;
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				return pa.z < pb.z;
+			};
+			std::sort(order.begin(), order.end(), lessPosition);
+
+			//Every vertex is renamed to the first vertex at its position
+			std::vector<uint8_t> locked(numVertices, 0);
+			std::vector<uint32_t> positionId(numVertices);
+			for (size_t i = 0; i < numVertices;)
+			{
+				size_t end = i + 1;
+				while (end < numVertices && !lessPosition(order[i], order[end])) {
+					end++;
+				}
+				for (size_t j = i; j < end; j++)
+				{
+					positionId[order[j]] = order[i];
+					if (end - i > 1) {
+						locked[order[j]] = 1;
+					}
+				}
+				i = end;
+			}
+
+			std::vector<uint64_t> edges;
+			edges.reserve(corners.size());
+			for (size_t t = 0; t < corners.size(); t += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint64_t a = positionId[corners[t + k]];
+					uint64_t b = positionId[corners[t + (k + 1) % 3]];
+					edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			std::vector<uint8_t> lockedPosition(numVertices, 0);
+			for (size_t i = 0; i < edges.size();)
+			{
+				size_t end = i + 1;
+				while (end < edges.size() && edges[end] == edges[i]) {
+					end++;
+				}
+				if (end - i != 2) {
+					lockedPosition[edges[i] >> 32] = 1;
+					lockedPosition[edges[i] & 0xFFFFFFFF] = 1;
+				}
+				i = end;
+			}
+			for (size_t v = 0; v < numVertices; v++)
+			{
+				if (lockedPosition[positionId[v]]) {
+					locked[v] = 1;
+				}
+			}
+			return locked;
+		}
+
+		/// <summary>
+		/// Greedy cheapest-first half edge collapses over one cluster. Only unlocked vertices move, and their
+		/// triangles all belong to this cluster, so clusters can run concurrently on the shared corner array.
+		/// </summary>
+		/// <returns>Largest cost of a collapse that was made</returns>
+		float simplifyCluster(const std::vector<Vertex>& vertices, std::vector<uint32_t>& corners, std::vector<uint8_t>& triangleAlive,
+			const std::vector<uint8_t>& locked, const std::vector<uint32_t>& triangles, size_t target, float maxError) {
+			size_t numTriangles = triangles.size();
+
+			//Local numbering keeps every per vertex array the size of the cluster
+			std::unordered_map<uint32_t, uint32_t> localIds;
+			localIds.reserve(numTriangles);
+			std::vector<uint32_t> globalIds;
+			std::vector<uint32_t> localCorners(numTriangles * 3);
+			std::vector<std::vector<uint32_t>> adjacency;
+			for (uint32_t t = 0; t < numTriangles; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint32_t v = corners[triangles[t] * 3 + k];
+					auto inserted = localIds.emplace(v, (uint32_t)globalIds.size());
+					if (inserted.second) {
+						globalIds.push_back(v);
+						adjacency.emplace_back();
+					}
+					localCorners[t * 3 + k] = inserted.first->second;
+					adjacency[inserted.first->second].push_back(t);
+				}
+			}
+			size_t numLocal = globalIds.size();
+			auto position = [&](uint32_t local) -> const ew::Vec3& { return vertices[globalIds[local]].pos; };
+
+			std::vector<Quadric> quadrics(numLocal);
+			for (uint32_t t = 0; t < numTriangles; t++)
+			{
+				const ew::Vec3& p0 = position(localCorners[t * 3]);
+				ew::Vec3 normal = ew::Cross(position(localCorners[t * 3 + 1]) - p0, position(localCorners[t * 3 + 2]) - p0);
+				float length = ew::Magnitude(normal);
+				if (length <= 0.0f)
+					continue;
+				normal = normal * (1.0f / length);
+				double d = -ew::Dot(normal, p0);
+				for (int k = 0; k < 3; k++)
+				{
+					quadrics[localCorners[t * 3 + k]].addPlane(normal.x, normal.y, normal.z, d);
+				}
+			}
+
+			std::vector<uint32_t> version(numLocal, 0);
+			std::vector<uint8_t> removed(numLocal, 0);
+			std::vector<uint8_t> alive(numTriangles, 1);
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+			auto neighbors = [&](uint32_t v, std::vector<uint32_t>* out) {
+				out->clear();
+				for (uint32_t t : adjacency[v])
+				{
+					if (!alive[t])
+						continue;
+					for (int k = 0; k < 3; k++)
+					{
+						uint32_t n = localCorners[t * 3 + k];
+						if (n != v && std::find(out->begin(), out->end(), n) == out->end())
+							out->push_back(n);
+					}
+				}
+			};
+			std::vector<uint32_t> scratch, scratchB;
+			auto pushBest = [&](uint32_t a) {
+				if (removed[a] || locked[globalIds[a]])
+					return;
+				neighbors(a, &scratch);
+				Collapse best = { 0.0f, a, a, version[a] };
+				double bestCost = 1e300;
+				for (uint32_t b : scratch)
+				{
+					double cost = quadrics[a].evaluate(position(b)) + quadrics[b].evaluate(position(b));
+					if (cost < bestCost) {
+						bestCost = cost;
+						best.to = b;
+					}
+				}
+				if (best.to != a) {
+					best.cost = (float)std::max(bestCost, 0.0);
+					queue.push(best);
+				}
+			};
+			//Rejects collapses that flip or squash a triangle, or that would join two sheets (link condition)
+			auto canCollapse = [&](uint32_t a, uint32_t b) {
+				const ew::Vec3& target = position(b);
+				int shared = 0;
+				for (uint32_t t : adjacency[a])
+				{
+					if (!alive[t])
+						continue;
+					uint32_t* c = &localCorners[t * 3];
+					if (c[0] == b || c[1] == b || c[2] == b) {
+						shared++;
+						continue;
+					}
+					ew::Vec3 p[3] = { position(c[0]), position(c[1]), position(c[2]) };
+					ew::Vec3 before = ew::Cross(p[1] - p[0], p[2] - p[0]);
+					for (int k = 0; k < 3; k++)
+					{
+						if (c[k] == a)
+							p[k] = target;
+					}
+					ew::Vec3 after = ew::Cross(p[1] - p[0], p[2] - p[0]);
+					float lengths = ew::Magnitude(before) * ew::Magnitude(after);
+					if (lengths <= 0.0f || ew::Dot(before, after) < 0.25f * lengths)
+						return false;
+				}
+				neighbors(a, &scratch);
+				neighbors(b, &scratchB);
+				int common = 0;
+				for (uint32_t n : scratch)
+				{
+					if (std::find(scratchB.begin(), scratchB.end(), n) != scratchB.end())
+						common++;
+				}
+				return shared > 0 && common <= shared;
+			};
+
+			for (uint32_t v = 0; v < numLocal; v++)
+			{
+				pushBest(v);
+			}
+			size_t remaining = numTriangles;
+			float largestCost = 0.0f;
+			std::vector<uint32_t> touched;
+			while (remaining > target && !queue.empty()) {
+				Collapse collapse = queue.top();
+				queue.pop();
+				uint32_t a = collapse.from, b = collapse.to;
+				if (removed[a] || removed[b] || collapse.version != version[a])
+					continue;
+				if (collapse.cost > maxError)
+					break;
+				if (!canCollapse(a, b))
+					continue;
+
+				for (uint32_t t : adjacency[a])
+				{
+					if (!alive[t])
+						continue;
+					uint32_t* c = &localCorners[t * 3];
+					if (c[0] == b || c[1] == b || c[2] == b) {
+						alive[t] = 0;
+						remaining--;
+						continue;
+					}
+					for (int k = 0; k < 3; k++)
+					{
+						if (c[k] == a)
+							c[k] = b;
+					}
+					adjacency[b].push_back(t);
+				}
+				quadrics[b].add(quadrics[a]);
+				removed[a] = 1;
+				adjacency[a].clear();
+				largestCost = std::max(largestCost, collapse.cost);
+
+				neighbors(b, &touched);
+				touched.push_back(b);
+				for (uint32_t v : touched)
+				{
+					version[v]++;
+					pushBest(v);
+				}
+			}
+
+			for (uint32_t t = 0; t < numTriangles; t++)
+			{
+				uint32_t global = triangles[t];
+				triangleAlive[global] = alive[t];
+				for (int k = 0; k < 3; k++)
+				{
+					corners[global * 3 + k] = globalIds[localCorners[t * 3 + k]];
+				}
+			}
+			return largestCost;
+		}
+	}
+
+	/// <summary>
+	/// Triangles are bucketed into a grid by centroid and each cell is simplified on its own thread, with vertices
+	/// shared between cells locked. A second pass over a grid shifted by half a cell simplifies those borders.
+	/// </summary>
+	MeshData simplifyMesh(const MeshData& meshData, const SimplifyOptions& options, SimplifyResult* result)
+	{
+		const std::vector<Vertex>& vertices = meshData.vertices;
+		size_t numTriangles = meshData.indices.size() / 3;
+		std::vector<uint32_t> corners(meshData.indices.begin(), meshData.indices.begin() + numTriangles * 3);
+		std::vector<uint8_t> triangleAlive(numTriangles, 1);
+		size_t target = (size_t)(numTriangles * std::min(std::max(options.targetRatio, 0.0f), 1.0f));
+
+		std::vector<uint8_t> attributeLocked = findAttributeLockedVertices(vertices, corners);
+		Bounds bounds = meshData.bounds.isValid() ? meshData.bounds : computeBounds(vertices);
+		size_t trianglesPerCluster = (size_t)std::max(options.trianglesPerCluster, 1);
+		int grid = (int)ceilf(cbrtf((float)std::max(numTriangles / trianglesPerCluster, (size_t)1)));
+		int passes = grid > 1 ? 2 : 1;
+		ew::Vec3 extent = bounds.max - bounds.min;
+		ew::Vec3 cellSize = ew::Vec3(
+			std::max(extent.x / grid, 1e-6f), std::max(extent.y / grid, 1e-6f), std::max(extent.z / grid, 1e-6f));
+
+		float error = 0.0f;
+		std::mutex errorMutex;
+		size_t current = numTriangles;
+		for (int pass = 0; pass < passes && current > target; pass++)
+		{
+			//The shifted grid has one more cell per axis
+			int cells = grid + pass;
+			ew::Vec3 offset = cellSize * (0.5f * pass);
+			std::vector<std::vector<uint32_t>> clusters((size_t)cells * cells * cells);
+			for (uint32_t t = 0; t < numTriangles; t++)
+			{
+				if (!triangleAlive[t])
+					continue;
+				ew::Vec3 centroid = (vertices[corners[t * 3]].pos + vertices[corners[t * 3 + 1]].pos + vertices[corners[t * 3 + 2]].pos) * (1.0f / 3.0f);
+				ew::Vec3 cell = centroid - bounds.min + offset;
+				int x = std::min(std::max((int)(cell.x / cellSize.x), 0), cells - 1);
+				int y = std::min(std::max((int)(cell.y / cellSize.y), 0), cells - 1);
+				int z = std::min(std::max((int)(cell.z / cellSize.z), 0), cells - 1);
+				clusters[((size_t)z * cells + y) * cells + x].push_back(t);
+			}
+
+			std::vector<uint8_t> locked = attributeLocked;
+			std::vector<uint32_t> owner(vertices.size(), NO_CLUSTER);
+			for (uint32_t c = 0; c < clusters.size(); c++)
+			{
+				for (uint32_t t : clusters[c])
+				{
+					for (int k = 0; k < 3; k++)
+					{
+						uint32_t v = corners[t * 3 + k];
+						if (owner[v] == NO_CLUSTER)
+							owner[v] = c;
+						else if (owner[v] != c)
+							locked[v] = 1;
+					}
+				}
+			}
+
+			//Each cluster keeps the same share of its triangles
+			double passRatio = (double)target / current;
+			getThreadPool().parallelFor(clusters.size(), 1, [&](size_t begin, size_t end) {
+				for (size_t c = begin; c < end; c++)
+				{
+					if (clusters[c].empty())
+						continue;
+					size_t clusterTarget = (size_t)ceil(clusters[c].size() * passRatio);
+					float clusterError = simplifyCluster(vertices, corners, triangleAlive, locked, clusters[c], clusterTarget, options.maxError);
+					std::lock_guard<std::mutex> lock(errorMutex);
+					error = std::max(error, clusterError);
+				}
+			});
+			current = 0;
+			for (size_t t = 0; t < numTriangles; t++)
+			{
+				current += triangleAlive[t];
+			}
+		}
+
+		MeshData out;
+		out.vertices = vertices;
+		out.indices.reserve(current * 3);
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			if (triangleAlive[t]) {
+				out.indices.insert(out.indices.end(), corners.begin() + t * 3, corners.begin() + t * 3 + 3);
+			}
+		}
+		//Drops vertices no longer referenced
+		optimizeVertexFetch(&out);
+		out.bounds = computeBounds(out.vertices);
+		if (result != NULL) {
+			result->trianglesBefore = numTriangles;
+			result->trianglesAfter = out.indices.size() / 3;
+			result->error = error;
+		}
+		return out;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	struct SimplifyOptions {
+		//Fraction of triangles to keep
+		float targetRatio = 0.5f;
+		//Collapses costing more than this are never made. Quadric error, roughly the squared distance moved from the original surface
+		float maxError = 1e30f;
+		//Triangles per independently simplified cluster. Each cluster runs on its own thread
+		int trianglesPerCluster = 16384;
+	};
+
+	struct SimplifyResult {
+		size_t trianglesBefore = 0;
+		size_t trianglesAfter = 0;
+		//Largest quadric error of any collapse that was made
+		float error = 0.0f;
+	};
+
+	/// <summary>
+	/// Quadric error metric simplification using half edge collapses, so every output vertex is an input vertex.
+	/// Vertices sharing a position with different normals or UVs (seams, hard edges) and open boundaries never move.
+	/// </summary>
+	MeshData simplifyMesh(const MeshData& meshData, const SimplifyOptions& options = SimplifyOptions(), SimplifyResult* result = NULL);
+}
@@ -0,0 +1,276 @@
+#include "meshlet.h"
+#include "frustum.h"
+#include "threadPool.h"
+#include "external/glad.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+namespace ew {
+	namespace {
+		//Cones whose widest normal is this close to perpendicular to the axis cannot cull anything useful
+		const float MIN_CONE_DOT = 0.1f;
+
+		inline ew::Vec3 getPosition(const MeshData& meshData, unsigned int index) {
+			return meshData.vertices[index].pos;
+		}
+		inline ew::Vec3 getCentroid(const MeshData& meshData, const unsigned int* triangle) {
+			return (getPosition(meshData, triangle[0]) + getPosition(meshData, triangle[1]) + getPosition(meshData, triangle[2])) / 3.0f;
+		}
+		inline float distanceSquared(const ew::Vec3& a, const ew::Vec3& b) {
+			ew::Vec3 d = a - b;
+			return ew::Dot(d, d);
+		}
+
+		/// <summary>
+		/// Box centered sphere around the meshlet's vertices, and the narrowest cone around its triangle normals
+		/// that shares their average as its axis.
+		/// </summary>
+		void computeMeshletBounds(const MeshData& meshData, Meshlet* meshlet) {
+			const unsigned int* indices = meshData.indices.data() + meshlet->firstIndex;
+			size_t numIndices = (size_t)meshlet->triangleCount * 3;
+			ew::Vec3 min = getPosition(meshData, indices[0]);
+			ew::Vec3 max = min;
+			for (size_t i = 1; i < numIndices; i++)
+			{
+				ew::Vec3 p = getPosition(meshData, indices[i]);
+				min = ew::Vec3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+				max = ew::Vec3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+			}
+			meshlet->center = (min + max) * 0.5f;
+			float radiusSquared = 0.0f;
+			for (size_t i = 0; i < numIndices; i++)
+				radiusSquared = fmaxf(radiusSquared, distanceSquared(getPosition(meshData, indices[i]), meshlet->center));
+			meshlet->radius = sqrtf(radiusSquared);
+
+			ew::Vec3 normals[MAX_MESHLET_TRIANGLES];
+			ew::Vec3 axis = ew::Vec3(0);
+			size_t numNormals = 0;
+			for (size_t i = 0; i < numIndices; i += 3)
+			{
+				ew::Vec3 a = getPosition(meshData, indices[i]);
+				ew::Vec3 n = ew::Cross(getPosition(meshData, indices[i + 1]) - a, getPosition(meshData, indices[i + 2]) - a);
+				float length = ew::Magnitude(n);
+				//Degenerate triangles are invisible whichever way they face
+				if (length == 0.0f)
+					continue;
+				normals[numNormals] = n / length;
+				axis += normals[numNormals++];
+			}
+			meshlet->coneAxis = ew::Vec3(0, 0, 1);
+			meshlet->coneCutoff = 1.0f;
+			float axisLength = ew::Magnitude(axis);
+			if (numNormals == 0 || axisLength == 0.0f)
+				return;
+			axis = axis / axisLength;
+			float minDot = 1.0f;
+			for (size_t i = 0; i < numNormals; i++)
+				minDot = fminf(minDot, ew::Dot(normals[i], axis));
+			meshlet->coneAxis = axis;
+			if (minDot > MIN_CONE_DOT) {
+				//Sine of the cone's half angle
+				meshlet->coneCutoff = sqrtf(1.0f - minDot * minDot);
+			}
+		}
+
+		//Applies the inverse of model's upper 3x3 to v
+		inline ew::Vec3 inverseLinear(const ew::Mat4& model, const ew::Vec3& v, float* determinant) {
+			ew::Vec3 c0 = ew::Vec3(model[0].x, model[0].y, model[0].z);
+			ew::Vec3 c1 = ew::Vec3(model[1].x, model[1].y, model[1].z);
+			ew::Vec3 c2 = ew::Vec3(model[2].x, model[2].y, model[2].z);
+			ew::Vec3 r0 = ew::Cross(c1, c2);
+			*determinant = ew::Dot(c0, r0);
+			return ew::Vec3(ew::Dot(r0, v), ew::Dot(ew::Cross(c2, c0), v), ew::Dot(ew::Cross(c0, c1), v)) / *determinant;
+		}
+	}
+
+	std::vector<Meshlet> buildMeshlets(MeshData* meshData)
+	{
+		std::vector<Meshlet> meshlets;
+		size_t numTriangles = meshData->indices.size() / 3;
+		size_t numVertices = meshData->vertices.size();
+		if (numTriangles == 0)
+			return meshlets;
+		const unsigned int* indices = meshData->indices.data();
+
+		//Triangles around each vertex, as offsets into one shared array
+		std::vector<unsigned int> adjacencyOffsets(numVertices + 1, 0);
+		for (size_t i = 0; i < numTriangles * 3; i++)
+			adjacencyOffsets[indices[i] + 1]++;
+		for (size_t i = 0; i < numVertices; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		std::vector<unsigned int> adjacency(numTriangles * 3);
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < numTriangles * 3; i++)
+				adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+
+		std::vector<bool> emitted(numTriangles, false);
+		//Meshlet number + 1 that last used each vertex, so membership is a single compare
+		std::vector<unsigned int> vertexOwner(numVertices, 0);
+		std::vector<unsigned int> candidates;
+		std::vector<unsigned int> reordered;
+		reordered.reserve(numTriangles * 3);
+		size_t nextSeed = 0;
+		size_t numEmitted = 0;
+
+		while (numEmitted < numTriangles) {
+			Meshlet meshlet;
+			meshlet.firstIndex = (unsigned int)reordered.size();
+			unsigned int owner = (unsigned int)meshlets.size() + 1;
+			ew::Vec3 centroidSum = ew::Vec3(0);
+			candidates.clear();
+
+			while (meshlet.triangleCount < MAX_MESHLET_TRIANGLES && numEmitted < numTriangles) {
+				//Best neighbor: fewest new vertices, then nearest to the meshlet's centroid
+				size_t best = SIZE_MAX;
+				unsigned int bestNew = 4;
+				float bestDistance = 0.0f;
+				ew::Vec3 centroid = meshlet.triangleCount > 0 ? centroidSum / (float)meshlet.triangleCount : ew::Vec3(0);
+				for (size_t i = 0; i < candidates.size();)
+				{
+					unsigned int triangle = candidates[i];
+					if (emitted[triangle]) {
+						candidates[i] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					const unsigned int* t = indices + (size_t)triangle * 3;
+					unsigned int numNew = (vertexOwner[t[0]] != owner) + (vertexOwner[t[1]] != owner) + (vertexOwner[t[2]] != owner);
+					if (meshlet.vertexCount + numNew <= MAX_MESHLET_VERTICES && numNew <= bestNew) {
+						float distance = distanceSquared(getCentroid(*meshData, t), centroid);
+						if (numNew < bestNew || distance < bestDistance) {
+							best = i;
+							bestNew = numNew;
+							bestDistance = distance;
+						}
+					}
+					i++;
+				}
+
+				unsigned int triangle;
+				if (best != SIZE_MAX) {
+					triangle = candidates[best];
+					candidates[best] = candidates.back();
+					candidates.pop_back();
+				}
+				else {
+					//Nothing connected fits. A well filled meshlet is closed, a sparse one (small separate parts) keeps going
+					if (meshlet.triangleCount >= MAX_MESHLET_TRIANGLES / 2 || meshlet.vertexCount + 3 > MAX_MESHLET_VERTICES)
+						break;
+					while (emitted[nextSeed])
+						nextSeed++;
+					triangle = (unsigned int)nextSeed;
+				}
+
+				const unsigned int* t = indices + (size_t)triangle * 3;
+				for (int i = 0; i < 3; i++)
+				{
+					if (vertexOwner[t[i]] == owner)
+						continue;
+					vertexOwner[t[i]] = owner;
+					meshlet.vertexCount++;
+					for (unsigned int j = adjacencyOffsets[t[i]]; j < adjacencyOffsets[t[i] + 1]; j++)
+					{
+						if (!emitted[adjacency[j]])
+							candidates.push_back(adjacency[j]);
+					}
+				}
+				reordered.insert(reordered.end(), t, t + 3);
+				emitted[triangle] = true;
+				numEmitted++;
+				meshlet.triangleCount++;
+				centroidSum += getCentroid(*meshData, t);
+			}
+			meshlets.push_back(meshlet);
+		}
+
+		meshData->indices.swap(reordered);
+		Meshlet* out = meshlets.data();
+		const MeshData& data = *meshData;
+		getThreadPool().parallelFor(meshlets.size(), 64, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				computeMeshletBounds(data, out + i);
+		});
+		return meshlets;
+	}
+
+	/// <summary>
+	/// Tests run in mesh space against the frustum of viewProjection * model and the camera moved by the inverse model matrix,
+	/// so bounds and cones are never transformed. Whether a triangle faces the camera survives any invertible affine transform.
+	/// </summary>
+	size_t MeshletCuller::cull(const std::vector<Meshlet>& meshlets, const ew::Mat4& model, const ew::Camera& camera)
+	{
+		m_counts.clear();
+		m_firstIndices.clear();
+		m_visibleCount = 0;
+		m_frustumCulled = 0;
+		m_backfaceCulled = 0;
+		m_visibleTriangles = 0;
+
+		Frustum frustum = extractFrustum(camera.ProjectionMatrix() * camera.ViewMatrix() * model);
+		float determinant;
+		ew::Vec3 translation = ew::Vec3(model[3].x, model[3].y, model[3].z);
+		ew::Vec3 eye = inverseLinear(model, camera.position - translation, &determinant);
+		ew::Vec3 viewDirection = ew::Normalize(inverseLinear(model, camera.target - camera.position, &determinant));
+		//Mirroring turns front faces into back faces
+		float facing = determinant < 0.0f ? -1.0f : 1.0f;
+
+		for (const Meshlet& meshlet : meshlets)
+		{
+			bool inside = true;
+			for (int i = 0; i < Frustum::PLANE_COUNT && inside; i++)
+			{
+				const Plane& plane = frustum.planes[i];
+				inside = ew::Dot(plane.normal, meshlet.center) + plane.distance >= -meshlet.radius;
+			}
+			if (!inside) {
+				m_frustumCulled++;
+				continue;
+			}
+			if (meshlet.coneCutoff < 1.0f) {
+				ew::Vec3 axis = meshlet.coneAxis * facing;
+				bool backFacing;
+				if (camera.orthographic) {
+					backFacing = ew::Dot(viewDirection, axis) >= meshlet.coneCutoff;
+				}
+				else {
+					//Every point of the sphere sees every normal of the cone from behind
+					ew::Vec3 toCenter = meshlet.center - eye;
+					backFacing = ew::Dot(toCenter, axis) >= meshlet.coneCutoff * ew::Magnitude(toCenter) + meshlet.radius;
+				}
+				if (backFacing) {
+					m_backfaceCulled++;
+					continue;
+				}
+			}
+			m_visibleCount++;
+			m_visibleTriangles += meshlet.triangleCount;
+			unsigned int count = meshlet.triangleCount * 3;
+			if (!m_counts.empty() && m_firstIndices.back() + m_counts.back() == meshlet.firstIndex) {
+				m_counts.back() += count;
+			}
+			else {
+				m_firstIndices.push_back(meshlet.firstIndex);
+				m_counts.push_back((int)count);
+			}
+		}
+		return m_visibleCount;
+	}
+
+	void MeshletCuller::draw(const Mesh& mesh) const
+	{
+		if (mesh.isPooled()) {
+			printf("MeshletCuller::draw does not support pooled meshes\n");
+			return;
+		}
+		if (m_counts.empty())
+			return;
+		m_offsets.resize(m_firstIndices.size());
+		for (size_t i = 0; i < m_firstIndices.size(); i++)
+			m_offsets[i] = (const void*)((size_t)m_firstIndices[i] * mesh.getIndexSize());
+		glBindVertexArray(mesh.getVAO());
+		glMultiDrawElements(GL_TRIANGLES, m_counts.data(), (GLenum)mesh.getIndexType(), m_offsets.data(), (GLsizei)m_counts.size());
+	}
+}
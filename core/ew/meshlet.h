@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+#include "camera.h"
+
+namespace ew {
+	const unsigned int MAX_MESHLET_VERTICES = 64;
+	const unsigned int MAX_MESHLET_TRIANGLES = 124;
+
+	/// <summary>
+	/// Cluster of triangles that is culled as a unit. Bounds and cone are in mesh space.
+	/// </summary>
+	struct Meshlet {
+		//Range of MeshData::indices, which buildMeshlets reorders so every meshlet is contiguous
+		unsigned int firstIndex = 0;
+		unsigned int triangleCount = 0;
+		unsigned int vertexCount = 0;
+		ew::Vec3 center = ew::Vec3(0);
+		float radius = 0.0f;
+		//Every triangle normal is within the cone around coneAxis whose half angle has sine coneCutoff.
+		//coneCutoff >= 1 means the normals are too spread out to ever cull
+		ew::Vec3 coneAxis = ew::Vec3(0, 0, 1);
+		float coneCutoff = 1.0f;
+	};
+
+	/// <summary>
+	/// Greedily grows meshlets of at most MAX_MESHLET_VERTICES and MAX_MESHLET_TRIANGLES through shared vertices,
+	/// preferring triangles that add the fewest new vertices, then the ones closest to the meshlet.
+	/// Reorders meshData->indices into meshlet order. Vertices are untouched, so the mesh can be uploaded as usual afterwards.
+	/// </summary>
+	std::vector<Meshlet> buildMeshlets(MeshData* meshData);
+
+	/// <summary>
+	/// Rejects meshlets outside the camera frustum or entirely back facing, then draws the survivors from a Mesh
+	/// built from the reordered MeshData. Adjacent visible meshlets are merged into one range,
+	/// and all ranges go out in one glMultiDrawElements call.
+	/// </summary>
+	class MeshletCuller {
+	public:
+		//Returns the number of visible meshlets
+		size_t cull(const std::vector<Meshlet>& meshlets, const ew::Mat4& model, const ew::Camera& camera);
+		//Binds mesh's VAO and draws the ranges kept by the last cull. Mesh must not be pooled
+		void draw(const Mesh& mesh)const;
+		inline size_t getVisibleCount()const { return m_visibleCount; }
+		inline size_t getFrustumCulledCount()const { return m_frustumCulled; }
+		inline size_t getBackfaceCulledCount()const { return m_backfaceCulled; }
+		inline size_t getVisibleTriangles()const { return m_visibleTriangles; }
+		//Ranges submitted by draw after merging neighbors
+		inline size_t getRangeCount()const { return m_counts.size(); }
+	private:
+		std::vector<int> m_counts; //Index counts
+		std::vector<unsigned int> m_firstIndices;
+		mutable std::vector<const void*> m_offsets; //Byte offsets, built at draw time from the mesh's index size
+		size_t m_visibleCount = 0;
+		size_t m_frustumCulled = 0;
+		size_t m_backfaceCulled = 0;
+		size_t m_visibleTriangles = 0;
+	};
+}
@@ -0,0 +1,1056 @@
+#include "modelLoader.h"
+#include "mappedFile.h"
+#include "threadPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+
+namespace ew {
+	namespace {
+		//Smallest OBJ chunk handed to a thread, smaller files are parsed on the calling thread
+		const size_t MIN_OBJ_CHUNK_BYTES = 256 * 1024;
+		//Index value for a missing uv or normal, or a position that is out of range
+		const int MISSING_INDEX = INT_MIN;
+
+		const double POW10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		//Line breaks are handled by the callers, so '\n' is not a space here
+		inline bool isSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+		inline bool isDigit(char c) {
+			return (unsigned char)(c - '0') < 10;
+		}
+		inline const char* skipSpace(const char* p, const char* end) {
+			while (p < end && isSpace(*p))
+				p++;
+			return p;
+		}
+
+		/// <summary>
+		/// Decimal float without locale lookups or a terminating null, which the mapped file does not have.
+		/// Up to 17 significant digits are accumulated into an integer and scaled by an exact power of ten once.
+		/// Anything else (nan, inf, hex floats) falls back to strtod.
+		/// </summary>
+		/// <returns>Pointer past the number, or p if there was none</returns>
+		const char* parseFloat(const char* p, const char* end, float* out) {
+			const char* start = p;
+			bool negative = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negative = *p == '-';
+				p++;
+			}
+			uint64_t mantissa = 0;
+			int exponent = 0;
+			bool anyDigits = false;
+			for (; p < end && isDigit(*p); p++) {
+				anyDigits = true;
+				if (mantissa < 10000000000000000ull)
+					mantissa = mantissa * 10 + (*p - '0');
+				else
+					exponent++;
+			}
+			if (p < end && *p == '.') {
+				for (p++; p < end && isDigit(*p); p++) {
+					anyDigits = true;
+					if (mantissa < 10000000000000000ull) {
+						mantissa = mantissa * 10 + (*p - '0');
+						exponent--;
+					}
+				}
+			}
+			if (!anyDigits) {
+				char buffer[64];
+				size_t length = 0;
+				for (p = start; p < end && length < sizeof(buffer) - 1 && !isSpace(*p) && *p != '\n'; p++)
+					buffer[length++] = *p;
+				buffer[length] = 0;
+				char* parsedEnd;
+				*out = strtof(buffer, &parsedEnd);
+				return start + (parsedEnd - buffer);
+			}
+			if (p < end && (*p == 'e' || *p == 'E')) {
+				const char* e = p + 1;
+				bool negativeExponent = false;
+				if (e < end && (*e == '-' || *e == '+')) {
+					negativeExponent = *e == '-';
+					e++;
+				}
+				if (e < end && isDigit(*e)) {
+					int value = 0;
+					for (; e < end && isDigit(*e); e++) {
+						if (value < 10000)
+							value = value * 10 + (*e - '0');
+					}
+					exponent += negativeExponent ? -value : value;
+					p = e;
+				}
+			}
+			double value = (double)mantissa;
+			if (exponent < 0)
+				value = exponent >= -22 ? value / POW10[-exponent] : value * pow(10.0, exponent);
+			else if (exponent > 0)
+				value = exponent <= 22 ? value * POW10[exponent] : value * pow(10.0, exponent);
+			*out = (float)(negative ? -value : value);
+			return p;
+		}
+		const char* parseInt(const char* p, const char* end, long long* out) {
+			const char* start = p;
+			bool negative = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negative = *p == '-';
+				p++;
+			}
+			if (p >= end || !isDigit(*p))
+				return start;
+			long long value = 0;
+			for (; p < end && isDigit(*p); p++) {
+				if (value < INT_MAX)
+					value = value * 10 + (*p - '0');
+			}
+			*out = negative ? -value : value;
+			return p;
+		}
+
+		//Vertex of a face as written. Negative OBJ indices are relative to the chunk's own count
+		//until the counts of earlier chunks are known, which the matching relative bit records
+		struct ObjCorner {
+			int position;
+			int uv;
+			int normal;
+			unsigned char relative;
+		};
+		const unsigned char RELATIVE_POSITION = 1;
+		const unsigned char RELATIVE_UV = 2;
+		const unsigned char RELATIVE_NORMAL = 4;
+
+		struct ObjChunk {
+			const char* begin = nullptr;
+			const char* end = nullptr;
+			std::vector<float> positions; //xyz
+			std::vector<float> uvs; //uv
+			std::vector<float> normals; //xyz
+			std::vector<ObjCorner> corners; //3 per triangle
+			size_t positionBase = 0;
+			size_t uvBase = 0;
+			size_t normalBase = 0;
+			size_t cornerBase = 0;
+			size_t missingNormals = 0;
+		};
+
+		const char* parseFloats(const char* p, const char* end, int count, std::vector<float>* out) {
+			for (int i = 0; i < count; i++)
+			{
+				float value = 0.0f;
+				p = skipSpace(p, end);
+				p = parseFloat(p, end, &value);
+				out->push_back(value);
+			}
+			return p;
+		}
+		inline int resolveObjIndex(long long index, size_t count, unsigned char bit, unsigned char* relative) {
+			if (index > 0)
+				return (int)(index - 1);
+			if (index < 0) {
+				*relative |= bit;
+				return (int)((long long)count + index);
+			}
+			return MISSING_INDEX;
+		}
+
+		void parseObjChunk(ObjChunk* chunk) {
+			std::vector<ObjCorner> polygon;
+			const char* p = chunk->begin;
+			while (p < chunk->end) {
+				const char* lineEnd = (const char*)memchr(p, '\n', chunk->end - p);
+				if (lineEnd == nullptr)
+					lineEnd = chunk->end;
+				p = skipSpace(p, lineEnd);
+				if (lineEnd - p >= 2 && p[0] == 'v') {
+					if (isSpace(p[1]))
+						parseFloats(p + 2, lineEnd, 3, &chunk->positions);
+					else if (p[1] == 't' && lineEnd - p >= 3 && isSpace(p[2]))
+						parseFloats(p + 3, lineEnd, 2, &chunk->uvs);
+					else if (p[1] == 'n' && lineEnd - p >= 3 && isSpace(p[2]))
+						parseFloats(p + 3, lineEnd, 3, &chunk->normals);
+				}
+				else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+					polygon.clear();
+					p += 2;
+					while (true) {
+						p = skipSpace(p, lineEnd);
+						long long index = 0;
+						const char* next = parseInt(p, lineEnd, &index);
+						if (next == p)
+							break;
+						p = next;
+						ObjCorner corner;
+						corner.relative = 0;
+						corner.position = resolveObjIndex(index, chunk->positions.size() / 3, RELATIVE_POSITION, &corner.relative);
+						corner.uv = MISSING_INDEX;
+						corner.normal = MISSING_INDEX;
+						if (p < lineEnd && *p == '/') {
+							p++;
+							index = 0;
+							next = parseInt(p, lineEnd, &index);
+							if (next != p) {
+								corner.uv = resolveObjIndex(index, chunk->uvs.size() / 2, RELATIVE_UV, &corner.relative);
+								p = next;
+							}
+							if (p < lineEnd && *p == '/') {
+								p++;
+								index = 0;
+								next = parseInt(p, lineEnd, &index);
+								if (next != p) {
+									corner.normal = resolveObjIndex(index, chunk->normals.size() / 3, RELATIVE_NORMAL, &corner.relative);
+									p = next;
+								}
+							}
+						}
+						polygon.push_back(corner);
+						//Skip anything unexpected up to the next corner
+						while (p < lineEnd && !isSpace(*p))
+							p++;
+					}
+					for (size_t i = 2; i < polygon.size(); i++)
+					{
+						chunk->corners.push_back(polygon[0]);
+						chunk->corners.push_back(polygon[i - 1]);
+						chunk->corners.push_back(polygon[i]);
+					}
+				}
+				p = lineEnd + 1;
+			}
+		}
+
+		//Converts the chunk's indices to file wide ones. Triangles touching a missing position are dropped by
+		//marking all three corners, bad uv and normal indices are treated as absent
+		void resolveObjChunk(ObjChunk* chunk, size_t numPositions, size_t numUvs, size_t numNormals) {
+			for (size_t i = 0; i < chunk->corners.size(); i += 3)
+			{
+				bool valid = true;
+				for (size_t j = i; j < i + 3; j++)
+				{
+					ObjCorner& c = chunk->corners[j];
+					if (c.relative & RELATIVE_POSITION)
+						c.position += (int)chunk->positionBase;
+					if (c.relative & RELATIVE_UV)
+						c.uv += (int)chunk->uvBase;
+					if (c.relative & RELATIVE_NORMAL)
+						c.normal += (int)chunk->normalBase;
+					if (c.position < 0 || (size_t)c.position >= numPositions)
+						valid = false;
+					if (c.uv < 0 || (size_t)c.uv >= numUvs)
+						c.uv = MISSING_INDEX;
+					if (c.normal < 0 || (size_t)c.normal >= numNormals)
+						c.normal = MISSING_INDEX;
+				}
+				for (size_t j = i; j < i + 3; j++)
+				{
+					if (!valid)
+						chunk->corners[j].position = MISSING_INDEX;
+					else if (chunk->corners[j].normal == MISSING_INDEX)
+						chunk->missingNormals++;
+				}
+			}
+		}
+
+		inline uint64_t hashCorner(const ObjCorner& c) {
+			uint64_t h = (uint64_t)(uint32_t)c.position * 0x9E3779B97F4A7C15ull;
+			h ^= ((uint64_t)(uint32_t)c.uv + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+			h ^= ((uint64_t)(uint32_t)c.normal + 0x165667B19E3779F9ull) * 0x85EBCA77C2B2AE63ull;
+			return h ^ (h >> 29);
+		}
+
+		/// <summary>
+		/// Open addressing map from position/uv/normal triplets to vertex indices.
+		/// Each dedupe shard owns one, so no locking is needed.
+		/// </summary>
+		class CornerMap {
+		public:
+			CornerMap(size_t expected) {
+				size_t capacity = 64;
+				while (capacity < expected * 2)
+					capacity *= 2;
+				m_slots.resize(capacity);
+			}
+			//Returns the vertex index of c, adding it to keys if it is new
+			uint32_t insert(const ObjCorner& c, uint64_t hash) {
+				if ((m_keys.size() + 1) * 2 > m_slots.size())
+					grow();
+				size_t mask = m_slots.size() - 1;
+				for (size_t i = (size_t)hash & mask; ; i = (i + 1) & mask) {
+					Slot& slot = m_slots[i];
+					if (slot.vertex == EMPTY) {
+						slot.position = c.position;
+						slot.uv = c.uv;
+						slot.normal = c.normal;
+						slot.vertex = (uint32_t)m_keys.size();
+						m_keys.push_back(c);
+						return slot.vertex;
+					}
+					if (slot.position == c.position && slot.uv == c.uv && slot.normal == c.normal)
+						return slot.vertex;
+				}
+			}
+			inline const std::vector<ObjCorner>& getKeys()const { return m_keys; }
+		private:
+			static const uint32_t EMPTY = 0xFFFFFFFF;
+			struct Slot {
+				int position = 0;
+				int uv = 0;
+				int normal = 0;
+				uint32_t vertex = EMPTY;
+			};
+			void grow() {
+				std::vector<Slot> old;
+				old.swap(m_slots);
+				m_slots.resize(old.size() * 2);
+				size_t mask = m_slots.size() - 1;
+				for (const Slot& slot : old)
+				{
+					if (slot.vertex == EMPTY)
+						continue;
+					ObjCorner c = { slot.position, slot.uv, slot.normal, 0 };
+					size_t i = (size_t)hashCorner(c) & mask;
+					while (m_slots[i].vertex != EMPTY)
+						i = (i + 1) & mask;
+					m_slots[i] = slot;
+				}
+			}
+			std::vector<Slot> m_slots;
+			std::vector<ObjCorner> m_keys;
+		};
+
+		/// <summary>
+		/// Minimal JSON reader for the glTF chunk of a .glb. Object members keep their file order.
+		/// </summary>
+		struct JsonValue {
+			enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+			Type type = NUL;
+			double number = 0.0;
+			std::string string;
+			std::vector<JsonValue> elements;
+			std::vector<std::string> keys; //Parallel to elements for objects
+
+			const JsonValue* find(const char* key)const {
+				if (type != OBJECT)
+					return nullptr;
+				for (size_t i = 0; i < keys.size(); i++)
+				{
+					if (keys[i] == key)
+						return &elements[i];
+				}
+				return nullptr;
+			}
+			const JsonValue* at(size_t i)const {
+				return type == ARRAY && i < elements.size() ? &elements[i] : nullptr;
+			}
+			//Child element i of member key, e.g. get("accessors", 3)
+			const JsonValue* get(const char* key, size_t i)const {
+				const JsonValue* array = find(key);
+				return array ? array->at(i) : nullptr;
+			}
+			double getNumber(const char* key, double fallback)const {
+				const JsonValue* value = find(key);
+				return value && value->type == NUMBER ? value->number : fallback;
+			}
+		};
+
+		class JsonParser {
+		public:
+			JsonParser(const char* begin, const char* end) :m_p(begin), m_end(end) {}
+			bool parse(JsonValue* out) {
+				return parseValue(out, 0);
+			}
+		private:
+			static const int MAX_DEPTH = 64;
+			void skipWhitespace() {
+				while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+					m_p++;
+			}
+			bool match(const char* literal) {
+				size_t length = strlen(literal);
+				if ((size_t)(m_end - m_p) < length || memcmp(m_p, literal, length) != 0)
+					return false;
+				m_p += length;
+				return true;
+			}
+			bool parseString(std::string* out) {
+				if (m_p >= m_end || *m_p != '"')
+					return false;
+				m_p++;
+				while (m_p < m_end && *m_p != '"') {
+					if (*m_p == '\\') {
+						if (++m_p >= m_end)
+							return false;
+						switch (*m_p) {
+						case 'n': out->push_back('\n'); break;
+						case 't': out->push_back('\t'); break;
+						case 'r': out->push_back('\r'); break;
+						case 'b': out->push_back('\b'); break;
+						case 'f': out->push_back('\f'); break;
+						case 'u':
+							//Only used for names here, so anything outside ASCII becomes '?'
+							if (m_end - m_p < 5)
+								return false;
+							out->push_back('?');
+							m_p += 4;
+							break;
+						default: out->push_back(*m_p); break;
+						}
+						m_p++;
+					}
+					else {
+						out->push_back(*m_p++);
+					}
+				}
+				if (m_p >= m_end)
+					return false;
+				m_p++;
+				return true;
+			}
+			bool parseValue(JsonValue* out, int depth) {
+				if (depth > MAX_DEPTH)
+					return false;
+				skipWhitespace();
+				if (m_p >= m_end)
+					return false;
+				switch (*m_p) {
+				case '{':
+					out->type = JsonValue::OBJECT;
+					m_p++;
+					skipWhitespace();
+					if (m_p < m_end && *m_p == '}') {
+						m_p++;
+						return true;
+					}
+					while (true) {
+						skipWhitespace();
+						out->keys.emplace_back();
+						if (!parseString(&out->keys.back()))
+							return false;
+						skipWhitespace();
+						if (m_p >= m_end || *m_p++ != ':')
+							return false;
+						out->elements.emplace_back();
+						if (!parseValue(&out->elements.back(), depth + 1))
+							return false;
+						skipWhitespace();
+						if (m_p >= m_end)
+							return false;
+						if (*m_p == '}') {
+							m_p++;
+							return true;
+						}
+						if (*m_p++ != ',')
+							return false;
+					}
+				case '[':
+					out->type = JsonValue::ARRAY;
+					m_p++;
+					skipWhitespace();
+					if (m_p < m_end && *m_p == ']') {
+						m_p++;
+						return true;
+					}
+					while (true) {
+						out->elements.emplace_back();
+						if (!parseValue(&out->elements.back(), depth + 1))
+							return false;
+						skipWhitespace();
+						if (m_p >= m_end)
+							return false;
+						if (*m_p == ']') {
+							m_p++;
+							return true;
+						}
+						if (*m_p++ != ',')
+							return false;
+					}
+				case '"':
+					out->type = JsonValue::STRING;
+					return parseString(&out->string);
+				case 't':
+					out->type = JsonValue::BOOLEAN;
+					out->number = 1.0;
+					return match("true");
+				case 'f':
+					out->type = JsonValue::BOOLEAN;
+					return match("false");
+				case 'n':
+					return match("null");
+				default: {
+					float value = 0.0f;
+					const char* next = parseFloat(m_p, m_end, &value);
+					if (next == m_p)
+						return false;
+					//Re-read in double precision, integers such as byte offsets must be exact
+					char buffer[64];
+					size_t length = (size_t)(next - m_p) < sizeof(buffer) - 1 ? (size_t)(next - m_p) : sizeof(buffer) - 1;
+					memcpy(buffer, m_p, length);
+					buffer[length] = 0;
+					out->type = JsonValue::NUMBER;
+					out->number = strtod(buffer, nullptr);
+					m_p = next;
+					return true;
+				}
+				}
+			}
+			const char* m_p;
+			const char* m_end;
+		};
+
+		const uint32_t GLB_MAGIC = 0x46546C67; //"glTF"
+		const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+		const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+		const int GLTF_FLOAT = 5126;
+		const int GLTF_UNSIGNED_INT = 5125;
+		const int GLTF_UNSIGNED_SHORT = 5123;
+		const int GLTF_SHORT = 5122;
+		const int GLTF_UNSIGNED_BYTE = 5121;
+		const int GLTF_BYTE = 5120;
+		const int GLTF_TRIANGLES = 4;
+
+		inline uint32_t readU32(const unsigned char* p) {
+			uint32_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		inline size_t getComponentSize(int componentType) {
+			switch (componentType) {
+			case GLTF_FLOAT: case GLTF_UNSIGNED_INT: return 4;
+			case GLTF_UNSIGNED_SHORT: case GLTF_SHORT: return 2;
+			case GLTF_UNSIGNED_BYTE: case GLTF_BYTE: return 1;
+			default: return 0;
+			}
+		}
+		inline int getNumComponents(const std::string& type) {
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			return 0;
+		}
+
+		//Strided view of an accessor inside the mapped BIN chunk
+		struct AccessorView {
+			const unsigned char* data = nullptr; //NULL for accessors without a buffer view, which read as zeros
+			size_t count = 0;
+			size_t stride = 0;
+			int componentType = 0;
+			int numComponents = 0;
+			bool normalized = false;
+
+			float getFloat(size_t i, int component)const {
+				if (data == nullptr || component >= numComponents)
+					return 0.0f;
+				const unsigned char* p = data + i * stride + component * getComponentSize(componentType);
+				switch (componentType) {
+				case GLTF_FLOAT: { float v; memcpy(&v, p, 4); return v; }
+				case GLTF_UNSIGNED_INT: { uint32_t v; memcpy(&v, p, 4); return (float)v; }
+				case GLTF_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return normalized ? v / 65535.0f : (float)v; }
+				case GLTF_SHORT: { int16_t v; memcpy(&v, p, 2); return normalized ? fmaxf(v / 32767.0f, -1.0f) : (float)v; }
+				case GLTF_UNSIGNED_BYTE: return normalized ? *p / 255.0f : (float)*p;
+				case GLTF_BYTE: return normalized ? fmaxf((int8_t)*p / 127.0f, -1.0f) : (float)(int8_t)*p;
+				default: return 0.0f;
+				}
+			}
+			uint32_t getIndex(size_t i)const {
+				if (data == nullptr)
+					return 0;
+				const unsigned char* p = data + i * stride;
+				switch (componentType) {
+				case GLTF_UNSIGNED_INT: return readU32(p);
+				case GLTF_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return v; }
+				case GLTF_UNSIGNED_BYTE: return *p;
+				default: return 0;
+				}
+			}
+		};
+
+		struct GlbFile {
+			const std::string* path;
+			JsonValue json;
+			const unsigned char* bin = nullptr;
+			size_t binSize = 0;
+		};
+
+		bool getAccessor(const GlbFile& glb, size_t index, AccessorView* view) {
+			const JsonValue* accessor = glb.json.get("accessors", index);
+			const JsonValue* type = accessor ? accessor->find("type") : nullptr;
+			if (accessor == nullptr || type == nullptr) {
+				printf("%s: accessor %d is missing\n", glb.path->c_str(), (int)index);
+				return false;
+			}
+			view->count = (size_t)accessor->getNumber("count", 0);
+			view->componentType = (int)accessor->getNumber("componentType", 0);
+			view->numComponents = getNumComponents(type->string);
+			const JsonValue* normalized = accessor->find("normalized");
+			view->normalized = normalized && normalized->number != 0.0;
+			size_t elementSize = getComponentSize(view->componentType) * view->numComponents;
+			if (elementSize == 0) {
+				printf("%s: accessor %d has an unsupported type\n", glb.path->c_str(), (int)index);
+				return false;
+			}
+			if (accessor->find("sparse"))
+				printf("%s: sparse accessor %d is read without its sparse values\n", glb.path->c_str(), (int)index);
+			const JsonValue* bufferViewIndex = accessor->find("bufferView");
+			if (bufferViewIndex == nullptr) {
+				view->data = nullptr;
+				return true;
+			}
+			const JsonValue* bufferView = glb.json.get("bufferViews", (size_t)bufferViewIndex->number);
+			if (bufferView == nullptr) {
+				printf("%s: accessor %d references a missing buffer view\n", glb.path->c_str(), (int)index);
+				return false;
+			}
+			const JsonValue* buffer = glb.json.get("buffers", (size_t)bufferView->getNumber("buffer", 0));
+			if (buffer == nullptr || buffer->find("uri") != nullptr || glb.bin == nullptr) {
+				printf("%s: only data in the embedded BIN chunk is supported\n", glb.path->c_str());
+				return false;
+			}
+			size_t viewOffset = (size_t)bufferView->getNumber("byteOffset", 0);
+			size_t viewLength = (size_t)bufferView->getNumber("byteLength", 0);
+			size_t accessorOffset = (size_t)accessor->getNumber("byteOffset", 0);
+			view->stride = (size_t)bufferView->getNumber("byteStride", 0);
+			if (view->stride == 0)
+				view->stride = elementSize;
+			if (viewOffset + viewLength > glb.binSize || (view->count > 0 &&
+				accessorOffset + view->stride * (view->count - 1) + elementSize > viewLength)) {
+				printf("%s: accessor %d is out of bounds\n", glb.path->c_str(), (int)index);
+				return false;
+			}
+			view->data = glb.bin + viewOffset + accessorOffset;
+			return true;
+		}
+
+		ew::Mat4 getNodeMatrix(const JsonValue& node) {
+			const JsonValue* matrix = node.find("matrix");
+			if (matrix && matrix->elements.size() == 16) {
+				ew::Vec4 columns[4];
+				for (int i = 0; i < 4; i++)
+				{
+					columns[i] = ew::Vec4((float)matrix->elements[i * 4].number, (float)matrix->elements[i * 4 + 1].number,
+						(float)matrix->elements[i * 4 + 2].number, (float)matrix->elements[i * 4 + 3].number);
+				}
+				return ew::Mat4(columns[0], columns[1], columns[2], columns[3]);
+			}
+			float t[3] = { 0, 0, 0 }, r[4] = { 0, 0, 0, 1 }, s[3] = { 1, 1, 1 };
+			const JsonValue* value = node.find("translation");
+			for (size_t i = 0; value && i < 3 && i < value->elements.size(); i++)
+				t[i] = (float)value->elements[i].number;
+			value = node.find("rotation");
+			for (size_t i = 0; value && i < 4 && i < value->elements.size(); i++)
+				r[i] = (float)value->elements[i].number;
+			value = node.find("scale");
+			for (size_t i = 0; value && i < 3 && i < value->elements.size(); i++)
+				s[i] = (float)value->elements[i].number;
+			float x = r[0], y = r[1], z = r[2], w = r[3];
+			return ew::Mat4(
+				ew::Vec4(1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0) * s[0],
+				ew::Vec4(2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0) * s[1],
+				ew::Vec4(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0) * s[2],
+				ew::Vec4(t[0], t[1], t[2], 1));
+		}
+
+		//Adds area weighted face normals to every corner's vertex, then normalizes
+		void generateNormals(ew::Vertex* vertices, size_t numVertices, const unsigned int* indices, size_t numIndices) {
+			for (size_t i = 0; i < numVertices; i++)
+				vertices[i].normal = ew::Vec3(0);
+			for (size_t i = 0; i + 2 < numIndices; i += 3)
+			{
+				ew::Vertex& a = vertices[indices[i]];
+				ew::Vertex& b = vertices[indices[i + 1]];
+				ew::Vertex& c = vertices[indices[i + 2]];
+				ew::Vec3 normal = ew::Cross(b.pos - a.pos, c.pos - a.pos);
+				a.normal += normal;
+				b.normal += normal;
+				c.normal += normal;
+			}
+			for (size_t i = 0; i < numVertices; i++)
+				vertices[i].normal = ew::Normalize(vertices[i].normal);
+		}
+
+		bool appendPrimitive(const GlbFile& glb, const JsonValue& primitive, const ew::Mat4& model, MeshData* meshData) {
+			if ((int)primitive.getNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES)
+				return true;
+			const JsonValue* attributes = primitive.find("attributes");
+			const JsonValue* positionIndex = attributes ? attributes->find("POSITION") : nullptr;
+			if (positionIndex == nullptr)
+				return true;
+			AccessorView positions, normals, uvs, indices;
+			if (!getAccessor(glb, (size_t)positionIndex->number, &positions))
+				return false;
+			const JsonValue* normalIndex = attributes->find("NORMAL");
+			if (normalIndex && !getAccessor(glb, (size_t)normalIndex->number, &normals))
+				return false;
+			const JsonValue* uvIndex = attributes->find("TEXCOORD_0");
+			if (uvIndex && !getAccessor(glb, (size_t)uvIndex->number, &uvs))
+				return false;
+			const JsonValue* indicesIndex = primitive.find("indices");
+			if (indicesIndex && !getAccessor(glb, (size_t)indicesIndex->number, &indices))
+				return false;
+			if (normals.count < positions.count)
+				normals.data = nullptr;
+			if (uvs.count < positions.count)
+				uvs.data = nullptr;
+
+			size_t baseVertex = meshData->vertices.size();
+			size_t baseIndex = meshData->indices.size();
+			size_t numVertices = positions.count;
+			size_t numIndices = indicesIndex ? indices.count / 3 * 3 : numVertices / 3 * 3;
+			meshData->vertices.resize(baseVertex + numVertices);
+			meshData->indices.resize(baseIndex + numIndices);
+			ew::Vertex* vertices = meshData->vertices.data() + baseVertex;
+			unsigned int* out = meshData->indices.data() + baseIndex;
+
+			//Normals use the cofactor matrix, which is the inverse transpose times the determinant.
+			//Mirroring transforms have a negative determinant, so the normals are negated back,
+			//and they flip the winding, so triangles are reversed to stay counter clockwise
+			ew::Vec3 c0 = ew::Vec3(model[0].x, model[0].y, model[0].z);
+			ew::Vec3 c1 = ew::Vec3(model[1].x, model[1].y, model[1].z);
+			ew::Vec3 c2 = ew::Vec3(model[2].x, model[2].y, model[2].z);
+			ew::Vec3 n0 = ew::Cross(c1, c2), n1 = ew::Cross(c2, c0), n2 = ew::Cross(c0, c1);
+			bool mirrored = ew::Dot(c0, n0) < 0.0f;
+			float normalSign = mirrored ? -1.0f : 1.0f;
+
+			ew::getThreadPool().parallelFor(numVertices, 4096, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					ew::Vec4 p = model * ew::Vec4(positions.getFloat(i, 0), positions.getFloat(i, 1), positions.getFloat(i, 2), 1.0f);
+					vertices[i].pos = ew::Vec3(p.x, p.y, p.z);
+					ew::Vec3 n = ew::Vec3(normals.getFloat(i, 0), normals.getFloat(i, 1), normals.getFloat(i, 2));
+					vertices[i].normal = ew::Normalize((n0 * n.x + n1 * n.y + n2 * n.z) * normalSign);
+					//glTF puts v = 0 at the top of the image, textures here are sampled with v = 0 at the bottom
+					vertices[i].uv = ew::Vec2(uvs.getFloat(i, 0), 1.0f - uvs.getFloat(i, 1));
+				}
+			});
+			bool valid = true;
+			for (size_t i = 0; i < numIndices; i++)
+			{
+				uint32_t index = indicesIndex ? indices.getIndex(i) : (uint32_t)i;
+				if (index >= numVertices) {
+					valid = false;
+					index = 0;
+				}
+				out[i] = (unsigned int)(baseVertex + index);
+			}
+			if (!valid)
+				printf("%s: primitive has out of range indices\n", glb.path->c_str());
+			if (mirrored) {
+				for (size_t i = 0; i < numIndices; i += 3)
+				{
+					unsigned int temp = out[i + 1];
+					out[i + 1] = out[i + 2];
+					out[i + 2] = temp;
+				}
+			}
+			if (normals.data == nullptr) {
+				//Local indices so the pass only touches this primitive
+				std::vector<unsigned int> local(out, out + numIndices);
+				for (unsigned int& index : local)
+					index -= (unsigned int)baseVertex;
+				generateNormals(vertices, numVertices, local.data(), local.size());
+			}
+			return true;
+		}
+
+		bool appendNode(const GlbFile& glb, size_t nodeIndex, const ew::Mat4& parent, int depth, MeshData* meshData) {
+			const JsonValue* node = glb.json.get("nodes", nodeIndex);
+			//Depth limit guards against cycles in malformed files
+			if (node == nullptr || depth > 64)
+				return true;
+			ew::Mat4 model = parent * getNodeMatrix(*node);
+			const JsonValue* meshIndex = node->find("mesh");
+			if (meshIndex) {
+				const JsonValue* mesh = glb.json.get("meshes", (size_t)meshIndex->number);
+				const JsonValue* primitives = mesh ? mesh->find("primitives") : nullptr;
+				for (size_t i = 0; primitives && i < primitives->elements.size(); i++)
+				{
+					if (!appendPrimitive(glb, primitives->elements[i], model, meshData))
+						return false;
+				}
+			}
+			const JsonValue* children = node->find("children");
+			for (size_t i = 0; children && i < children->elements.size(); i++)
+			{
+				if (!appendNode(glb, (size_t)children->elements[i].number, model, depth + 1, meshData))
+					return false;
+			}
+			return true;
+		}
+	}
+
+	bool loadOBJ(const std::string& path, MeshData* meshData)
+	{
+		MappedFile file;
+		if (!file.open(path.c_str())) {
+			printf("Failed to open %s\n", path.c_str());
+			return false;
+		}
+		const char* data = (const char*)file.getData();
+		size_t size = file.getSize();
+
+		//Chunk boundaries are moved forward to the next line start so no line is split
+		ThreadPool& pool = getThreadPool();
+		size_t numChunks = size / MIN_OBJ_CHUNK_BYTES;
+		size_t maxChunks = (size_t)(pool.getNumThreads() + 1) * 4;
+		numChunks = numChunks < 1 ? 1 : (numChunks > maxChunks ? maxChunks : numChunks);
+		std::vector<ObjChunk> chunks(numChunks);
+		const char* begin = data;
+		for (size_t i = 0; i < numChunks; i++)
+		{
+			const char* end = data + size * (i + 1) / numChunks;
+			if (i + 1 < numChunks && end > begin) {
+				const char* lineEnd = (const char*)memchr(end, '\n', data + size - end);
+				end = lineEnd ? lineEnd + 1 : data + size;
+			}
+			if (end < begin)
+				end = begin;
+			chunks[i].begin = begin;
+			chunks[i].end = end;
+			begin = end;
+		}
+		pool.parallelFor(numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+			for (size_t i = chunkBegin; i < chunkEnd; i++)
+				parseObjChunk(&chunks[i]);
+		});
+
+		size_t numPositions = 0, numUvs = 0, numNormals = 0, numCorners = 0;
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.positionBase = numPositions;
+			chunk.uvBase = numUvs;
+			chunk.normalBase = numNormals;
+			chunk.cornerBase = numCorners;
+			numPositions += chunk.positions.size() / 3;
+			numUvs += chunk.uvs.size() / 2;
+			numNormals += chunk.normals.size() / 3;
+			numCorners += chunk.corners.size();
+		}
+		if (numPositions > INT_MAX || numCorners > UINT_MAX) {
+			printf("%s is too large\n", path.c_str());
+			return false;
+		}
+		std::vector<float> positions(numPositions * 3), uvs(numUvs * 2), normals(numNormals * 3);
+		pool.parallelFor(numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+			for (size_t i = chunkBegin; i < chunkEnd; i++)
+			{
+				ObjChunk& chunk = chunks[i];
+				resolveObjChunk(&chunk, numPositions, numUvs, numNormals);
+				if (!chunk.positions.empty())
+					memcpy(&positions[chunk.positionBase * 3], chunk.positions.data(), chunk.positions.size() * sizeof(float));
+				if (!chunk.uvs.empty())
+					memcpy(&uvs[chunk.uvBase * 2], chunk.uvs.data(), chunk.uvs.size() * sizeof(float));
+				if (!chunk.normals.empty())
+					memcpy(&normals[chunk.normalBase * 3], chunk.normals.data(), chunk.normals.size() * sizeof(float));
+				std::vector<float>().swap(chunk.positions);
+				std::vector<float>().swap(chunk.uvs);
+				std::vector<float>().swap(chunk.normals);
+			}
+		});
+
+		//Smooth normals by position, for corners that did not specify one
+		size_t missingNormals = 0;
+		for (const ObjChunk& chunk : chunks)
+			missingNormals += chunk.missingNormals;
+		std::vector<ew::Vec3> generatedNormals;
+		if (missingNormals > 0) {
+			generatedNormals.assign(numPositions, ew::Vec3(0));
+			for (const ObjChunk& chunk : chunks)
+			{
+				for (size_t i = 0; i < chunk.corners.size(); i += 3)
+				{
+					const ObjCorner* c = &chunk.corners[i];
+					if (c[0].position == MISSING_INDEX)
+						continue;
+					const float* a = &positions[(size_t)c[0].position * 3];
+					const float* b = &positions[(size_t)c[1].position * 3];
+					const float* d = &positions[(size_t)c[2].position * 3];
+					ew::Vec3 normal = ew::Cross(ew::Vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), ew::Vec3(d[0] - a[0], d[1] - a[1], d[2] - a[2]));
+					generatedNormals[c[0].position] += normal;
+					generatedNormals[c[1].position] += normal;
+					generatedNormals[c[2].position] += normal;
+				}
+			}
+			pool.parallelFor(numPositions, 4096, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					generatedNormals[i] = ew::Normalize(generatedNormals[i]);
+			});
+		}
+
+		//Dedupe is sharded by hash. Every shard scans all corners but only inserts its own,
+		//so each owns a private map and vertex range
+		size_t numShards = pool.getNumThreads() + 1;
+		if (numShards > 64)
+			numShards = 64;
+		std::vector<CornerMap> maps;
+		maps.reserve(numShards);
+		for (size_t i = 0; i < numShards; i++)
+			maps.emplace_back(numPositions / numShards + 1);
+		std::vector<uint32_t> cornerVertices(numCorners);
+		pool.parallelFor(numShards, 1, [&](size_t shardBegin, size_t shardEnd) {
+			for (size_t shard = shardBegin; shard < shardEnd; shard++)
+			{
+				for (const ObjChunk& chunk : chunks)
+				{
+					for (size_t i = 0; i < chunk.corners.size(); i++)
+					{
+						const ObjCorner& c = chunk.corners[i];
+						if (c.position == MISSING_INDEX)
+							continue;
+						uint64_t hash = hashCorner(c);
+						if ((hash >> 32) % numShards == shard)
+							cornerVertices[chunk.cornerBase + i] = maps[shard].insert(c, hash);
+					}
+				}
+			}
+		});
+		std::vector<size_t> shardBases(numShards + 1, 0);
+		for (size_t i = 0; i < numShards; i++)
+			shardBases[i + 1] = shardBases[i] + maps[i].getKeys().size();
+
+		meshData->vertices.resize(shardBases[numShards]);
+		ew::Vertex* vertices = meshData->vertices.data();
+		pool.parallelFor(numShards, 1, [&](size_t shardBegin, size_t shardEnd) {
+			for (size_t shard = shardBegin; shard < shardEnd; shard++)
+			{
+				const std::vector<ObjCorner>& keys = maps[shard].getKeys();
+				ew::Vertex* v = vertices + shardBases[shard];
+				for (size_t i = 0; i < keys.size(); i++, v++)
+				{
+					const ObjCorner& c = keys[i];
+					const float* p = &positions[(size_t)c.position * 3];
+					v->pos = ew::Vec3(p[0], p[1], p[2]);
+					if (c.normal != MISSING_INDEX) {
+						const float* n = &normals[(size_t)c.normal * 3];
+						v->normal = ew::Vec3(n[0], n[1], n[2]);
+					}
+					else {
+						v->normal = generatedNormals[c.position];
+					}
+					v->uv = c.uv != MISSING_INDEX ? ew::Vec2(uvs[(size_t)c.uv * 2], uvs[(size_t)c.uv * 2 + 1]) : ew::Vec2(0, 0);
+				}
+			}
+		});
+
+		//Dropped triangles are compacted out, so each chunk's output offset needs its valid count first
+		std::vector<size_t> indexBases(numChunks + 1, 0);
+		for (size_t i = 0; i < numChunks; i++)
+		{
+			size_t valid = 0;
+			const std::vector<ObjCorner>& corners = chunks[i].corners;
+			for (size_t j = 0; j < corners.size(); j += 3)
+				valid += corners[j].position != MISSING_INDEX ? 3 : 0;
+			indexBases[i + 1] = indexBases[i] + valid;
+		}
+		meshData->indices.resize(indexBases[numChunks]);
+		unsigned int* indices = meshData->indices.data();
+		pool.parallelFor(numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+			for (size_t i = chunkBegin; i < chunkEnd; i++)
+			{
+				const ObjChunk& chunk = chunks[i];
+				unsigned int* out = indices + indexBases[i];
+				for (size_t j = 0; j < chunk.corners.size(); j++)
+				{
+					const ObjCorner& c = chunk.corners[j];
+					if (c.position == MISSING_INDEX)
+						continue;
+					size_t shard = (hashCorner(c) >> 32) % numShards;
+					*out++ = (unsigned int)(shardBases[shard] + cornerVertices[chunk.cornerBase + j]);
+				}
+			}
+		});
+		meshData->bounds = computeBounds(meshData->vertices);
+		return true;
+	}
+
+	bool loadGLB(const std::string& path, MeshData* meshData)
+	{
+		MappedFile file;
+		if (!file.open(path.c_str())) {
+			printf("Failed to open %s\n", path.c_str());
+			return false;
+		}
+		const unsigned char* data = file.getData();
+		size_t size = file.getSize();
+		if (size < 20 || readU32(data) != GLB_MAGIC || readU32(data + 4) != 2 || readU32(data + 8) > size) {
+			printf("%s is not a glTF 2.0 binary file\n", path.c_str());
+			return false;
+		}
+		size = readU32(data + 8);
+		size_t jsonLength = readU32(data + 12);
+		if (readU32(data + 16) != GLB_CHUNK_JSON || 20 + jsonLength > size) {
+			printf("%s has no JSON chunk\n", path.c_str());
+			return false;
+		}
+		GlbFile glb;
+		glb.path = &path;
+		JsonParser parser((const char*)data + 20, (const char*)data + 20 + jsonLength);
+		if (!parser.parse(&glb.json) || glb.json.type != JsonValue::OBJECT) {
+			printf("%s has malformed JSON\n", path.c_str());
+			return false;
+		}
+		//The BIN chunk is used in place, nothing is copied until the vertices are built
+		size_t binHeader = 20 + (jsonLength + 3) / 4 * 4;
+		if (binHeader + 8 <= size && readU32(data + binHeader + 4) == GLB_CHUNK_BIN) {
+			glb.bin = data + binHeader + 8;
+			glb.binSize = readU32(data + binHeader);
+			if (binHeader + 8 + glb.binSize > size) {
+				printf("%s has a truncated BIN chunk\n", path.c_str());
+				return false;
+			}
+		}
+
+		meshData->vertices.clear();
+		meshData->indices.clear();
+		ew::Mat4 identity = ew::IdentityMatrix();
+		const JsonValue* scene = glb.json.get("scenes", (size_t)glb.json.getNumber("scene", 0));
+		const JsonValue* nodes = scene ? scene->find("nodes") : nullptr;
+		if (nodes) {
+			for (size_t i = 0; i < nodes->elements.size(); i++)
+			{
+				if (!appendNode(glb, (size_t)nodes->elements[i].number, identity, 0, meshData))
+					return false;
+			}
+		}
+		else {
+			//No scene, every mesh is placed at the origin
+			const JsonValue* meshes = glb.json.find("meshes");
+			for (size_t i = 0; meshes && i < meshes->elements.size(); i++)
+			{
+				const JsonValue* primitives = meshes->elements[i].find("primitives");
+				for (size_t j = 0; primitives && j < primitives->elements.size(); j++)
+				{
+					if (!appendPrimitive(glb, primitives->elements[j], identity, meshData))
+						return false;
+				}
+			}
+		}
+		meshData->bounds = computeBounds(meshData->vertices);
+		return true;
+	}
+
+	bool loadModel(const std::string& path, MeshData* meshData)
+	{
+		size_t dot = path.find_last_of('.');
+		std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+		for (char& c : extension)
+			c = (char)tolower((unsigned char)c);
+		if (extension == "obj")
+			return loadOBJ(path, meshData);
+		if (extension == "glb")
+			return loadGLB(path, meshData);
+		printf("%s: unsupported model format, expected .obj or .glb\n", path.c_str());
+		return false;
+	}
+}
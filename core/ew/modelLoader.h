@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include "mesh.h"
+
+namespace ew {
+	/// <summary>
+	/// Wavefront OBJ. The file is split into line aligned chunks that are parsed in parallel,
+	/// then position/uv/normal triplets are deduplicated into ew::Vertex. Polygons are fan triangulated.
+	/// Corners without a normal get a smoothed normal generated from the faces around their position.
+	/// </summary>
+	bool loadOBJ(const std::string& path, MeshData* meshData);
+
+	/// <summary>
+	/// Binary glTF 2.0 (.glb) with its buffer embedded. Accessors are read straight out of the mapped file.
+	/// Every triangle primitive of the default scene is flattened into one mesh with node transforms applied.
+	/// </summary>
+	bool loadGLB(const std::string& path, MeshData* meshData);
+
+	//Picks a loader from the file extension
+	bool loadModel(const std::string& path, MeshData* meshData);
+}
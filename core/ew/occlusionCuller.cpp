@@ -0,0 +1,316 @@
+#include "occlusionCuller.h"
+#include "threadPool.h"
+#include "ewMath/simd.h"
+#include <algorithm>
+
+namespace ew {
+	namespace {
+		using namespace ew::simd;
+
+		//Rows rasterized by one job
+		const int BAND_HEIGHT = 16;
+		//A box is tested on the first pyramid level where it spans at most this many texels across.
+		//Lower reads less, higher culls more
+		const int TEST_TEXELS = 4;
+
+		const float LANE_OFFSETS[8] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+
+		inline ew::Vec4 lerpClip(const ew::Vec4& a, const ew::Vec4& b, float t) {
+			return ew::Vec4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller(int width, int height)
+	{
+		m_width = (int)(((size_t)width + LANES - 1) / LANES * LANES);
+		m_height = height;
+		//Halve until a single texel is left
+		int w = m_width, h = m_height;
+		while (true) {
+			m_levelSizes.push_back(w);
+			m_levelSizes.push_back(h);
+			m_levels.push_back(std::vector<float>((size_t)w * h, 1.0f));
+			if (w == 1 && h == 1)
+				break;
+			w = (w + 1) / 2;
+			h = (h + 1) / 2;
+		}
+	}
+
+	void OcclusionCuller::beginFrame(const ew::Mat4& viewProjection)
+	{
+		m_viewProjection = viewProjection;
+		m_occluders.clear();
+	}
+
+	void OcclusionCuller::addOccluder(const MeshData& meshData, const ew::Mat4& model)
+	{
+		m_occluders.push_back({ &meshData, model });
+	}
+
+	void OcclusionCuller::rasterize()
+	{
+		ThreadPool& pool = getThreadPool();
+
+		//Transform and set up the triangles of each occluder
+		m_triangles.resize(m_occluders.size());
+		pool.parallelFor(m_occluders.size(), 1, [&](size_t begin, size_t end) {
+			std::vector<ew::Vec4> clip;
+			for (size_t o = begin; o < end; o++)
+			{
+				const MeshData& meshData = *m_occluders[o].meshData;
+				ew::Mat4 mvp = m_viewProjection * m_occluders[o].model;
+				clip.resize(meshData.vertices.size());
+				for (size_t i = 0; i < clip.size(); i++)
+				{
+					clip[i] = mvp * ew::Vec4(meshData.vertices[i].pos, 1.0f);
+				}
+				std::vector<Triangle>& triangles = m_triangles[o];
+				triangles.clear();
+				for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3)
+				{
+					ew::Vec4 corners[3] = { clip[meshData.indices[i]], clip[meshData.indices[i + 1]], clip[meshData.indices[i + 2]] };
+					setupTriangle(corners, &triangles);
+				}
+			}
+		});
+		m_numTriangles = 0;
+		for (size_t o = 0; o < m_triangles.size(); o++)
+		{
+			m_numTriangles += m_triangles[o].size();
+		}
+
+		//Bands share no pixels, so they are written without locking
+		int numBands = (m_height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+		pool.parallelFor((size_t)numBands, 1, [&](size_t begin, size_t end) {
+			for (size_t band = begin; band < end; band++)
+			{
+				int minY = (int)band * BAND_HEIGHT;
+				rasterizeBand(minY, std::min(minY + BAND_HEIGHT, m_height) - 1);
+			}
+		});
+		buildPyramid();
+	}
+
+	/// <summary>
+	/// Clips against the near plane, culls back faces and converts what is left to window space edge and depth planes.
+	/// The other frustum planes only matter through the screen clamp of the bounding rectangle.
+	/// </summary>
+	void OcclusionCuller::setupTriangle(const ew::Vec4* clip, std::vector<Triangle>* triangles)const
+	{
+		//Sutherland-Hodgman against z >= -w leaves at most 4 corners
+		ew::Vec4 polygon[4];
+		int numCorners = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const ew::Vec4& a = clip[i];
+			const ew::Vec4& b = clip[(i + 1) % 3];
+			float da = a.z + a.w;
+			float db = b.z + b.w;
+			if (da >= 0.0f)
+				polygon[numCorners++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f))
+				polygon[numCorners++] = lerpClip(a, b, da / (da - db));
+		}
+		if (numCorners < 3)
+			return;
+
+		ew::Vec3 window[4];
+		for (int i = 0; i < numCorners; i++)
+		{
+			//w can only reach 0 where z does too, at the eye, so keep it strictly positive
+			float invW = 1.0f / std::max(polygon[i].w, 1e-6f);
+			window[i] = ew::Vec3(
+				(polygon[i].x * invW * 0.5f + 0.5f) * m_width,
+				(polygon[i].y * invW * 0.5f + 0.5f) * m_height,
+				polygon[i].z * invW * 0.5f + 0.5f);
+		}
+		for (int fan = 1; fan + 1 < numCorners; fan++)
+		{
+			const ew::Vec3 v[3] = { window[0], window[fan], window[fan + 1] };
+			//Counter clockwise is front facing, as with glFrontFace(GL_CCW)
+			float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+			if (!(area > 0.0f))
+				continue;
+			Triangle triangle;
+			float minX = v[0].x, maxX = v[0].x, minY = v[0].y, maxY = v[0].y;
+			for (int e = 0; e < 3; e++)
+			{
+				//Edge from v[e] to the next corner, positive on its left
+				const ew::Vec3& a = v[e];
+				const ew::Vec3& b = v[(e + 1) % 3];
+				triangle.edgeA[e] = a.y - b.y;
+				triangle.edgeB[e] = b.x - a.x;
+				triangle.edgeC[e] = -(triangle.edgeA[e] * a.x + triangle.edgeB[e] * a.y);
+				minX = std::min(minX, a.x); maxX = std::max(maxX, a.x);
+				minY = std::min(minY, a.y); maxY = std::max(maxY, a.y);
+			}
+			//Pixel centers sit at +0.5, so the covered pixels are the ones whose centers fall in the rectangle
+			triangle.minX = std::max((int)floorf(minX - 0.5f) + 1, 0);
+			triangle.maxX = std::min((int)floorf(maxX - 0.5f), m_width - 1);
+			triangle.minY = std::max((int)floorf(minY - 0.5f) + 1, 0);
+			triangle.maxY = std::min((int)floorf(maxY - 0.5f), m_height - 1);
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+				continue;
+
+			//Window depth is affine in x and y, so it is a plane through the three corners
+			ew::Vec3 normal = ew::Cross(v[1] - v[0], v[2] - v[0]);
+			triangle.depthA = -normal.x / normal.z;
+			triangle.depthB = -normal.y / normal.z;
+			triangle.depthC = v[0].z - triangle.depthA * v[0].x - triangle.depthB * v[0].y;
+			triangles->push_back(triangle);
+		}
+	}
+
+	/// <summary>
+	/// Keeps the nearest depth per pixel over every triangle touching rows [minY, maxY], LANES pixels at a time.
+	/// </summary>
+	void OcclusionCuller::rasterizeBand(int minY, int maxY)
+	{
+		float* depth = m_levels[0].data();
+		for (int y = minY; y <= maxY; y++)
+		{
+			float* row = depth + (size_t)y * m_width;
+			for (int x = 0; x < m_width; x++)
+			{
+				row[x] = 1.0f;
+			}
+		}
+		const FloatN laneOffsets = loadN(LANE_OFFSETS);
+		const FloatN zero = setN(0.0f);
+		for (size_t o = 0; o < m_triangles.size(); o++)
+		{
+			for (const Triangle& t : m_triangles[o])
+			{
+				int y0 = std::max(t.minY, minY);
+				int y1 = std::min(t.maxY, maxY);
+				if (y0 > y1)
+					continue;
+				//Start on a lane boundary. Pixels outside the triangle fail the edge tests
+				int x0 = (int)(t.minX / LANES * LANES);
+				for (int y = y0; y <= y1; y++)
+				{
+					float py = (float)y + 0.5f;
+					//Everything but the x terms is constant along the row
+					FloatN rowEdge0 = setN(t.edgeB[0] * py + t.edgeC[0]);
+					FloatN rowEdge1 = setN(t.edgeB[1] * py + t.edgeC[1]);
+					FloatN rowEdge2 = setN(t.edgeB[2] * py + t.edgeC[2]);
+					FloatN rowDepth = setN(t.depthB * py + t.depthC);
+					float* row = depth + (size_t)y * m_width;
+					for (int x = x0; x <= t.maxX; x += (int)LANES)
+					{
+						FloatN px = addN(setN((float)x), laneOffsets);
+						FloatN e0 = addN(mulN(setN(t.edgeA[0]), px), rowEdge0);
+						FloatN e1 = addN(mulN(setN(t.edgeA[1]), px), rowEdge1);
+						FloatN e2 = addN(mulN(setN(t.edgeA[2]), px), rowEdge2);
+						FloatN inside = andN(andN(geN(e0, zero), geN(e1, zero)), geN(e2, zero));
+						if (!movemaskN(inside))
+							continue;
+						FloatN z = addN(mulN(setN(t.depthA), px), rowDepth);
+						FloatN old = loadN(row + x);
+						//old + (min - old) where inside, old elsewhere
+						FloatN nearest = subN(minN(old, z), old);
+						storeN(row + x, addN(old, andN(inside, nearest)));
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Each texel keeps the farthest depth of the up to 2x2 texels under it on the previous level.
+	/// </summary>
+	void OcclusionCuller::buildPyramid()
+	{
+		ThreadPool& pool = getThreadPool();
+		for (int level = 1; level < getNumLevels(); level++)
+		{
+			const std::vector<float>& source = m_levels[level - 1];
+			std::vector<float>& destination = m_levels[level];
+			int sourceWidth = getLevelWidth(level - 1);
+			int sourceHeight = getLevelHeight(level - 1);
+			int width = getLevelWidth(level);
+			pool.parallelFor((size_t)getLevelHeight(level), 8, [&](size_t begin, size_t end) {
+				for (size_t y = begin; y < end; y++)
+				{
+					int y0 = (int)y * 2;
+					int y1 = std::min(y0 + 1, sourceHeight - 1);
+					for (int x = 0; x < width; x++)
+					{
+						int x0 = x * 2;
+						int x1 = std::min(x0 + 1, sourceWidth - 1);
+						destination[y * width + x] = std::max(
+							std::max(source[(size_t)y0 * sourceWidth + x0], source[(size_t)y0 * sourceWidth + x1]),
+							std::max(source[(size_t)y1 * sourceWidth + x0], source[(size_t)y1 * sourceWidth + x1]));
+					}
+				}
+			});
+		}
+	}
+
+	/// <summary>
+	/// Projects the 8 box corners to a window rectangle and nearest depth, then compares it to the farthest occluder depth
+	/// of every texel under the rectangle on the level where it is at most TEST_TEXELS wide.
+	/// </summary>
+	bool OcclusionCuller::isOccluded(const Bounds& worldBounds)const
+	{
+		float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, minZ = 1e30f;
+		for (int i = 0; i < 8; i++)
+		{
+			ew::Vec4 corner = ew::Vec4(
+				(i & 1) ? worldBounds.max.x : worldBounds.min.x,
+				(i & 2) ? worldBounds.max.y : worldBounds.min.y,
+				(i & 4) ? worldBounds.max.z : worldBounds.min.z, 1.0f);
+			ew::Vec4 clip = m_viewProjection * corner;
+			//In front of the near plane or behind the eye, so it may cover the whole screen
+			if (clip.z + clip.w < 0.0f || clip.w <= 0.0f)
+				return false;
+			float invW = 1.0f / clip.w;
+			float x = (clip.x * invW * 0.5f + 0.5f) * m_width;
+			float y = (clip.y * invW * 0.5f + 0.5f) * m_height;
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW * 0.5f + 0.5f);
+		}
+		//Entirely off screen is for the frustum test to decide
+		if (maxX < 0.0f || maxY < 0.0f || minX >= (float)m_width || minY >= (float)m_height)
+			return false;
+		//Every pixel the rectangle touches, plus one around it. Occluders are sampled at pixel centers and can
+		//claim a whole pixel they only partly cover
+		int x0 = std::max((int)floorf(minX) - 1, 0);
+		int x1 = std::min((int)floorf(maxX) + 1, m_width - 1);
+		int y0 = std::max((int)floorf(minY) - 1, 0);
+		int y1 = std::min((int)floorf(maxY) + 1, m_height - 1);
+		int level = 0;
+		while (level + 1 < getNumLevels() && std::max(x1 - x0, y1 - y0) >= TEST_TEXELS) {
+			level++;
+			x0 >>= 1; x1 >>= 1;
+			y0 >>= 1; y1 >>= 1;
+		}
+		const std::vector<float>& depth = m_levels[level];
+		int width = getLevelWidth(level);
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				if (depth[(size_t)y * width + x] >= minZ)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	size_t OcclusionCuller::cull(const BoundsBatch& batch, const std::vector<unsigned int>& candidates, std::vector<unsigned int>* visible)const
+	{
+		size_t before = visible->size();
+		for (unsigned int i : candidates)
+		{
+			Bounds bounds;
+			bounds.min = ew::Vec3(batch.minX[i], batch.minY[i], batch.minZ[i]);
+			bounds.max = ew::Vec3(batch.maxX[i], batch.maxY[i], batch.maxZ[i]);
+			if (!isOccluded(bounds))
+				visible->push_back(i);
+		}
+		return visible->size() - before;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+#include "frustum.h"
+
+namespace ew {
+	/// <summary>
+	/// CPU occlusion culling with no GPU involvement, so it never waits on a readback.
+	/// Occluder triangles are rasterized into a small depth buffer, LANES pixels at a time, one band of rows per job.
+	/// A hierarchical Z pyramid then keeps the farthest depth of every 2x2 block, so testing a bounding box reads
+	/// a few texels from the level where it covers about four across.
+	/// Depth is window depth in [0, 1], with empty pixels at 1.
+	/// </summary>
+	class OcclusionCuller {
+	public:
+		//width is rounded up to a multiple of the SIMD width
+		OcclusionCuller(int width = 256, int height = 128);
+
+		//Clears the occluders. viewProjection is used for rasterizing and testing until the next beginFrame
+		void beginFrame(const ew::Mat4& viewProjection);
+		//Queues a mesh as an occluder. Front facing triangles of meshData are rasterized, so it must stay alive until rasterize.
+		//Large, simple, solid meshes work best. Occluders should not poke out of their visible geometry
+		void addOccluder(const MeshData& meshData, const ew::Mat4& model);
+		//Transforms and rasterizes the queued occluders on the thread pool, then builds the pyramid
+		void rasterize();
+
+		//True if worldBounds is entirely behind the occluders. Bounds crossing the near plane are never occluded
+		bool isOccluded(const Bounds& worldBounds)const;
+		//Appends every index of candidates whose box in batch is not occluded to visible, keeping their order.
+		//Meant to run on the output of cullBoxes. Returns the number appended
+		size_t cull(const BoundsBatch& batch, const std::vector<unsigned int>& candidates, std::vector<unsigned int>* visible)const;
+
+		inline int getWidth()const { return m_width; }
+		inline int getHeight()const { return m_height; }
+		inline int getNumLevels()const { return (int)m_levels.size(); }
+		inline int getLevelWidth(int level)const { return m_levelSizes[level * 2]; }
+		inline int getLevelHeight(int level)const { return m_levelSizes[level * 2 + 1]; }
+		//Row major, bottom row first. Level 0 is the rasterized depth buffer
+		inline const std::vector<float>& getLevel(int level)const { return m_levels[level]; }
+		//Front facing triangles rasterized by the last rasterize, after near plane clipping
+		inline size_t getRasterizedTriangles()const { return m_numTriangles; }
+	private:
+		//Screen space triangle. Edge functions are >= 0 inside, and depth is a plane over the screen
+		struct Triangle {
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			int minX, maxX, minY, maxY;
+		};
+		struct Occluder {
+			const MeshData* meshData;
+			ew::Mat4 model;
+		};
+		void setupTriangle(const ew::Vec4* clip, std::vector<Triangle>* triangles)const;
+		void rasterizeBand(int minY, int maxY);
+		void buildPyramid();
+		int m_width;
+		int m_height;
+		ew::Mat4 m_viewProjection;
+		std::vector<Occluder> m_occluders;
+		std::vector<std::vector<Triangle>> m_triangles; //Per occluder
+		std::vector<std::vector<float>> m_levels;
+		std::vector<int> m_levelSizes; //Width, height per level
+		size_t m_numTriangles = 0;
+	};
+}
@@ -4,9 +4,28 @@
 
 
 #include "procGen.h"
+#include "threadPool.h"
+#include "meshOptimizer.h"
 #include <stdlib.h>
 
 namespace ew {
+	static bool s_optimizeGeneratedMeshes = false;
+
+	void setOptimizeGeneratedMeshes(bool enabled)
+	{
+		s_optimizeGeneratedMeshes = enabled;
+	}
+	bool getOptimizeGeneratedMeshes()
+	{
+		return s_optimizeGeneratedMeshes;
+	}
+	void finishGeneratedMesh(MeshData* mesh)
+	{
+		if (s_optimizeGeneratedMeshes) {
+			optimizeMesh(mesh);
+		}
+		mesh->bounds = computeBounds(mesh->vertices);
+	}
 	/// <summary>
 	/// Helper function for createCube. Note that this is not meant to be used standalone
 	/// </summary>
@@ -55,100 +74,142 @@ namespace ew {
 		createCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
 		createCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
 		createCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		finishGeneratedMesh(&mesh);
 		return mesh;
 	}
+	//Rows per parallelFor range. Small meshes stay on the calling thread
+	static const size_t MIN_ROWS_PER_RANGE = 32;
+
 	MeshData createPlane(float width, float height, int subdivisions)
 	{
-		//VERTICES
 		MeshData mesh;
-		int columns = subdivisions + 1;
-		for (size_t row = 0; row <= subdivisions; row++)
-		{
-			for (size_t col = 0; col <= subdivisions; col++)
+		size_t columns = subdivisions + 1;
+		mesh.vertices.resize(columns * columns);
+		mesh.indices.resize((size_t)subdivisions * subdivisions * 6);
+		Vertex* vertices = mesh.vertices.data();
+		unsigned int* indices = mesh.indices.data();
+
+		//VERTICES
+		getThreadPool().parallelFor(columns, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			for (size_t row = rowBegin; row < rowEnd; row++)
 			{
-				Vertex v;
-				v.uv.x = ((float)col / subdivisions);
-				v.uv.y = ((float)row / subdivisions);
-				v.pos.x = -width/2 + width * v.uv.x;
-				v.pos.y = 0;
-				v.pos.z = height/2 -height * v.uv.y;
-				v.normal = ew::Vec3(0, 1, 0);
-				mesh.vertices.push_back(v);
+				Vertex* v = vertices + row * columns;
+				float uvY = (float)row / subdivisions;
+				for (size_t col = 0; col < columns; col++, v++)
+				{
+					v->uv.x = ((float)col / subdivisions);
+					v->uv.y = uvY;
+					v->pos.x = -width / 2 + width * v->uv.x;
+					v->pos.y = 0;
+					v->pos.z = height / 2 - height * uvY;
+					v->normal = ew::Vec3(0, 1, 0);
+				}
 			}
-		}
+		});
 		//INDICES
-		for (size_t row = 0; row < subdivisions; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+		getThreadPool().parallelFor(subdivisions, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			unsigned int* out = indices + rowBegin * subdivisions * 6;
+			for (size_t row = rowBegin; row < rowEnd; row++)
 			{
-				int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start);
+				for (size_t col = 0; col < (size_t)subdivisions; col++)
+				{
+					unsigned int start = row * columns + col;
+					*out++ = start;
+					*out++ = start + 1;
+					*out++ = start + columns + 1;
+					*out++ = start + columns + 1;
+					*out++ = start + columns;
+					*out++ = start;
+				}
 			}
-		}
+		});
+		finishGeneratedMesh(&mesh);
 		return mesh;
 	}
 	MeshData createSphere(float radius, int subdivisions)
 	{
 		MeshData mesh;
-		//VERTICES
+		size_t columns = subdivisions + 1;
+		//Caps are one triangle per column, the rows between them two
+		size_t capIndices = (size_t)subdivisions * 3;
+		size_t sideRows = subdivisions > 2 ? subdivisions - 2 : 0;
+		mesh.vertices.resize(columns * columns);
+		mesh.indices.resize(capIndices * 2 + sideRows * subdivisions * 6);
+		Vertex* vertices = mesh.vertices.data();
+		unsigned int* indices = mesh.indices.data();
+
+		//Every row shares the same column angles, so sin/cos is evaluated once per column and once per row
 		float thetaStep = ew::TAU / subdivisions;
 		float phiStep = ew::PI / subdivisions;
-		for (size_t row = 0; row <= subdivisions; row++)
+		std::vector<float> cosTheta(columns), sinTheta(columns);
+		for (size_t col = 0; col < columns; col++)
 		{
-			float phi = row * phiStep;
-			for (size_t col = 0; col <= subdivisions; col++)
+			cosTheta[col] = cosf(thetaStep * col);
+			sinTheta[col] = sinf(thetaStep * col);
+		}
+		const float* cosT = cosTheta.data();
+		const float* sinT = sinTheta.data();
+
+		//VERTICES
+		getThreadPool().parallelFor(columns, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			for (size_t row = rowBegin; row < rowEnd; row++)
 			{
-				float theta = thetaStep * col;
-				Vertex v;
-				v.normal.x = cosf(theta) * sinf(phi);
-				v.normal.y = cosf(phi);
-				v.normal.z = sinf(theta) * sinf(phi);
-				v.pos = v.normal * radius;
-				v.uv.x = (float)col / subdivisions;
-				v.uv.y = 1.0 - ((float)row / subdivisions);
-				mesh.vertices.push_back(v);
+				float phi = row * phiStep;
+				float cosPhi = cosf(phi);
+				float sinPhi = sinf(phi);
+				float uvY = 1.0 - ((float)row / subdivisions);
+				Vertex* v = vertices + row * columns;
+				for (size_t col = 0; col < columns; col++, v++)
+				{
+					v->normal.x = cosT[col] * sinPhi;
+					v->normal.y = cosPhi;
+					v->normal.z = sinT[col] * sinPhi;
+					v->pos = v->normal * radius;
+					v->uv.x = (float)col / subdivisions;
+					v->uv.y = uvY;
+				}
 			}
-		}
-		
+		});
+
 		//INDICES
-		unsigned int columns = subdivisions + 1;
+		//Top cap
 		unsigned int sideStart = columns;
 		unsigned int poleStart = 0;
-		//Top cap
-		for (size_t i = 0; i < subdivisions; i++)
+		unsigned int* out = indices;
+		for (size_t i = 0; i < (size_t)subdivisions; i++)
 		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(poleStart + i);
-			mesh.indices.push_back(sideStart +i+1);
+			*out++ = sideStart + i;
+			*out++ = poleStart + i;
+			*out++ = sideStart + i + 1;
 		}
 		//Rows of quads for sides
-		for (size_t row = 1; row < subdivisions - 1; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+		getThreadPool().parallelFor(sideRows, MIN_ROWS_PER_RANGE, [=](size_t rowBegin, size_t rowEnd) {
+			unsigned int* out = indices + capIndices + rowBegin * subdivisions * 6;
+			for (size_t row = rowBegin + 1; row < rowEnd + 1; row++)
 			{
-				int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
+				for (size_t col = 0; col < (size_t)subdivisions; col++)
+				{
+					unsigned int start = row * columns + col;
+					*out++ = start;
+					*out++ = start + 1;
+					*out++ = start + columns;
+					*out++ = start + columns;
+					*out++ = start + 1;
+					*out++ = start + columns + 1;
+				}
 			}
-		}
+		});
 		//Bottom cap
 		poleStart = (columns * columns) - columns;
 		sideStart = poleStart - columns;
-		for (size_t i = 0; i < subdivisions; i++)
+		out = indices + capIndices + sideRows * subdivisions * 6;
+		for (size_t i = 0; i < (size_t)subdivisions; i++)
 		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(sideStart + i + 1);
-			mesh.indices.push_back(poleStart + i);
+			*out++ = sideStart + i;
+			*out++ = sideStart + i + 1;
+			*out++ = poleStart + i;
 		}
+		finishGeneratedMesh(&mesh);
 		return mesh;
 	}
 	void createCylinderRing(MeshData* meshData, float radius, int subdivisions, float y, bool sideFacing) {
@@ -175,6 +236,8 @@ namespace ew {
 	MeshData createCylinder(float radius, float height, int subdivisions)
 	{
 		MeshData mesh;
+		mesh.vertices.reserve((subdivisions + 1) * 4 + 2);
+		mesh.indices.reserve((subdivisions + 1) * 12);
 
 		//VERTICES
 		{
@@ -232,6 +295,7 @@ namespace ew {
 				mesh.indices.push_back(sideStart + i + 1);
 			}
 		}
+		finishGeneratedMesh(&mesh);
 		return mesh;
 	}
 }
\ No newline at end of file
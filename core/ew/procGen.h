@@ -11,4 +11,14 @@ namespace ew {
 	MeshData createPlane(float width, float height, int subdivisions);
 	MeshData createSphere(float radius, int subdivisions);
 	MeshData createCylinder(float radius, float height, int subdivisions);
+
+	//Part of every MeshCache file name. Bump whenever any generator's output changes, ew or am.
+	//Debug builds compare cache hits against a fresh generation and report a missed bump
+	const unsigned int PROC_GEN_VERSION = 1;
+
+	//When enabled, every generator (ew and am) runs optimizeMesh on its output. Off by default
+	void setOptimizeGeneratedMeshes(bool enabled);
+	bool getOptimizeGeneratedMeshes();
+	//Applies the optional optimization and computes bounds. Called at the end of each generator
+	void finishGeneratedMesh(MeshData* mesh);
 }
@@ -0,0 +1,122 @@
+#include "renderQueue.h"
+
+namespace ew {
+	namespace {
+		const int PROGRAM_BITS = 10;
+		const int TEXTURE_BITS = 14;
+		const int VAO_BITS = 12;
+		const int DEPTH_BITS = 27;
+
+		inline uint64_t maskBits(uint64_t v, int bits) {
+			return v & ((1ull << bits) - 1);
+		}
+		//Folds the bound texture set into a small hash. Collisions only cost sort quality, never correctness
+		inline uint64_t hashTextures(const DrawPacket& packet) {
+			uint64_t h = 0;
+			for (int i = 0; i < packet.numTextures; i++)
+			{
+				h = h * 31 + packet.textures[i];
+			}
+			return h;
+		}
+	}
+
+	void RenderQueue::beginFrame()
+	{
+		m_state.invalidate();
+		m_state.resetStats();
+	}
+	void RenderQueue::clear()
+	{
+		m_packets.clear();
+	}
+	void RenderQueue::add(const DrawPacket& packet)
+	{
+		m_packets.push_back(packet);
+	}
+	uint64_t RenderQueue::makeKey(const DrawPacket& packet) const
+	{
+		float t = ew::Clamp(packet.depth / m_maxDepth, 0.0f, 1.0f);
+		uint64_t depth = (uint64_t)(t * (float)((1u << DEPTH_BITS) - 1));
+		uint64_t program = maskBits(packet.shader->getID(), PROGRAM_BITS);
+		uint64_t textures = maskBits(hashTextures(packet), TEXTURE_BITS);
+		uint64_t vao = maskBits(packet.mesh->getVAO(), VAO_BITS);
+		uint64_t state = (program << (TEXTURE_BITS + VAO_BITS)) | (textures << VAO_BITS) | vao;
+		if (packet.transparent) {
+			uint64_t farToNear = ((1u << DEPTH_BITS) - 1) - depth;
+			return (1ull << 63) | (farToNear << (63 - DEPTH_BITS)) | maskBits(state, 63 - DEPTH_BITS);
+		}
+		return (state << DEPTH_BITS) | depth;
+	}
+	/// <summary>
+	/// LSD radix sort of (key, packet index) pairs, one byte per pass.
+	/// Passes where every key has the same byte are skipped.
+	/// </summary>
+	void RenderQueue::sortKeys()
+	{
+		size_t n = m_keys.size();
+		m_keysScratch.resize(n);
+		m_orderScratch.resize(n);
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			size_t counts[256] = {};
+			for (size_t i = 0; i < n; i++)
+			{
+				counts[(m_keys[i] >> shift) & 0xFF]++;
+			}
+			if (counts[(m_keys[0] >> shift) & 0xFF] == n)
+				continue;
+			size_t offsets[256];
+			size_t sum = 0;
+			for (int b = 0; b < 256; b++)
+			{
+				offsets[b] = sum;
+				sum += counts[b];
+			}
+			for (size_t i = 0; i < n; i++)
+			{
+				size_t dst = offsets[(m_keys[i] >> shift) & 0xFF]++;
+				m_keysScratch[dst] = m_keys[i];
+				m_orderScratch[dst] = m_order[i];
+			}
+			m_keys.swap(m_keysScratch);
+			m_order.swap(m_orderScratch);
+		}
+	}
+	void RenderQueue::submit()
+	{
+		if (m_packets.empty())
+			return;
+		m_keys.resize(m_packets.size());
+		m_order.resize(m_packets.size());
+		for (size_t i = 0; i < m_packets.size(); i++)
+		{
+			m_keys[i] = makeKey(m_packets[i]);
+			m_order[i] = (uint32_t)i;
+		}
+		sortKeys();
+
+		for (size_t i = 0; i < m_order.size(); i++)
+		{
+			const DrawPacket& packet = m_packets[m_order[i]];
+			m_state.useProgram(packet.shader->getID());
+			for (int t = 0; t < packet.numTextures; t++)
+			{
+				m_state.bindTexture2D(t, packet.textures[t]);
+			}
+			m_state.bindVertexArray(packet.mesh->getVAO());
+
+			auto it = m_uniforms.find(packet.shader);
+			if (it == m_uniforms.end()) {
+				ShaderUniforms uniforms;
+				uniforms.model = packet.shader->getUniformId("_Model");
+				uniforms.normalMatrix = packet.shader->getUniformId("_NormalMatrix");
+				it = m_uniforms.emplace(packet.shader, uniforms).first;
+			}
+			packet.shader->setMat4(it->second.model, packet.model);
+			packet.shader->setMat4(it->second.normalMatrix, packet.normalMatrix);
+			packet.mesh->drawUnbound();
+		}
+		m_packets.clear();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "mesh.h"
+#include "shader.h"
+#include "glState.h"
+
+namespace ew {
+	//Everything needed to issue one draw
+	struct DrawPacket {
+		static const int MAX_TEXTURES = 4;
+		const Shader* shader = nullptr;
+		const Mesh* mesh = nullptr;
+		unsigned int textures[MAX_TEXTURES] = {}; //Bound to units 0..numTextures-1
+		int numTextures = 0;
+		ew::Mat4 model;
+		ew::Mat4 normalMatrix;
+		float depth = 0.0f; //Distance from the camera
+		bool transparent = false;
+	};
+
+	/// <summary>
+	/// Collects draw packets, radix sorts them by a packed 64 bit key and submits them through a GLStateCache.
+	/// Opaque key:      0 | program | textures | vao | depth (front to back)
+	/// Transparent key: 1 | inverted depth (back to front) | program | textures | vao
+	/// Each packet's shader must declare _Model and _NormalMatrix.
+	/// </summary>
+	class RenderQueue {
+	public:
+		//Depths are normalized against this distance before being packed into the key
+		void setMaxDepth(float maxDepth) { m_maxDepth = maxDepth; }
+		//Resets the per frame stats and forgets cached GL state, since other code may have bound things directly
+		void beginFrame();
+		void clear();
+		void add(const DrawPacket& packet);
+		//Sorts and draws every packet, then clears the queue
+		void submit();
+
+		inline size_t size()const { return m_packets.size(); }
+		inline GLStateCache& getStateCache() { return m_state; }
+		inline const GLStateCache::Stats& getStats()const { return m_state.getStats(); }
+	private:
+		struct ShaderUniforms {
+			UniformId model;
+			UniformId normalMatrix;
+		};
+		uint64_t makeKey(const DrawPacket& packet)const;
+		void sortKeys();
+		std::vector<DrawPacket> m_packets;
+		std::vector<uint64_t> m_keys;
+		std::vector<uint32_t> m_order;
+		std::vector<uint64_t> m_keysScratch;
+		std::vector<uint32_t> m_orderScratch;
+		std::unordered_map<const Shader*, ShaderUniforms> m_uniforms;
+		GLStateCache m_state;
+		float m_maxDepth = 100.0f;
+	};
+}
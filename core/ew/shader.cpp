@@ -1,6 +1,7 @@
 #include "shader.h"
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include "external/glad.h"
 
 namespace ew {
@@ -73,6 +74,42 @@ namespace ew {
 		return shaderProgram;
 	}
 	/// <summary>
+	/// Reflects the locations of all active uniforms in a linked program.
+	/// Elements of arrays are added individually, so "_Array[2]" resolves without asking the driver.
+	/// </summary>
+	/// <param name="program">Linked shader program handle</param>
+	/// <returns>Map of uniform name to location</returns>
+	std::unordered_map<std::string, int> getActiveUniformLocations(unsigned int program) {
+		std::unordered_map<std::string, int> locations;
+		int numUniforms = 0;
+		int maxNameLength = 0;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+		std::vector<char> nameBuffer(maxNameLength + 1);
+		const GLenum properties[2] = { GL_LOCATION, GL_ARRAY_SIZE };
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int values[2];
+			glGetProgramResourceiv(program, GL_UNIFORM, i, 2, properties, 2, NULL, values);
+			//Members of uniform blocks have no location
+			if (values[0] < 0)
+				continue;
+			glGetProgramResourceName(program, GL_UNIFORM, i, (GLsizei)nameBuffer.size(), NULL, nameBuffer.data());
+			std::string name = nameBuffer.data();
+			locations[name] = values[0];
+			//Arrays of basic types are only reported as "name[0]"
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+				std::string baseName = name.substr(0, name.size() - 3);
+				locations[baseName] = values[0];
+				for (int j = 1; j < values[1]; j++)
+				{
+					locations[baseName + "[" + std::to_string(j) + "]"] = values[0] + j;
+				}
+			}
+		}
+		return locations;
+	}
+	/// <summary>
 	/// Creates a shader instance with vertex + fragment stages
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
@@ -82,6 +119,16 @@ namespace ew {
 		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
 		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_uniformLocations = ew::getActiveUniformLocations(m_id);
+	}
+	/// <summary>
+	/// Looks up a uniform in the reflected table. Inactive or unknown uniforms return -1, which GL ignores.
+	/// </summary>
+	int Shader::getUniformLocation(const std::string& name) const
+	{
+		m_lookupCount++;
+		auto it = m_uniformLocations.find(name);
+		return it != m_uniformLocations.end() ? it->second : -1;
 	}
 	void Shader::use()const
 	{
@@ -89,15 +136,15 @@ namespace ew {
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1i(getUniformLocation(name), v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1f(getUniformLocation(name), v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	void Shader::setVec2(const std::string& name, const ew::Vec2& v) const
 	{
@@ -105,7 +152,7 @@ namespace ew {
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	void Shader::setVec3(const std::string& name, const ew::Vec3& v) const
 	{
@@ -113,7 +160,7 @@ namespace ew {
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	void Shader::setVec4(const std::string& name, const ew::Vec4& v) const
 	{
@@ -121,7 +168,51 @@ namespace ew {
 	}
 	void Shader::setMat4(const std::string& name, const ew::Mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &m[0][0]);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &m[0][0]);
+	}
+	/// <summary>
+	/// Resolves a uniform name once, for use with the UniformId setters in hot loops
+	/// </summary>
+	UniformId Shader::getUniformId(const std::string& name) const
+	{
+		UniformId id;
+		id.location = getUniformLocation(name);
+		return id;
+	}
+	void Shader::setInt(UniformId id, int v) const
+	{
+		glUniform1i(id.location, v);
+	}
+	void Shader::setFloat(UniformId id, float v) const
+	{
+		glUniform1f(id.location, v);
+	}
+	void Shader::setVec2(UniformId id, const ew::Vec2& v) const
+	{
+		glUniform2f(id.location, v.x, v.y);
+	}
+	void Shader::setVec3(UniformId id, const ew::Vec3& v) const
+	{
+		glUniform3f(id.location, v.x, v.y, v.z);
+	}
+	void Shader::setVec4(UniformId id, const ew::Vec4& v) const
+	{
+		glUniform4f(id.location, v.x, v.y, v.z, v.w);
+	}
+	void Shader::setMat4(UniformId id, const ew::Mat4& m) const
+	{
+		glUniformMatrix4fv(id.location, 1, GL_FALSE, &m[0][0]);
+	}
+	/// <summary>
+	/// Points a uniform block at a binding point. Blocks the program does not use are ignored.
+	/// </summary>
+	/// <param name="blockName">Name of the block in GLSL, e.g. "FrameData"</param>
+	/// <param name="binding">Binding point of the UniformBuffer that feeds it</param>
+	void Shader::bindUniformBlock(const std::string& blockName, unsigned int binding) const
+	{
+		unsigned int blockIndex = glGetUniformBlockIndex(m_id, blockName.c_str());
+		if (blockIndex == GL_INVALID_INDEX)
+			return;
+		glUniformBlockBinding(m_id, blockIndex, binding);
 	}
 }
-
@@ -1,14 +1,23 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include "ewMath/ewMath.h"
 
 namespace ew {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+	std::unordered_map<std::string, int> getActiveUniformLocations(unsigned int program);
+
+	//Precomputed uniform location. Setting a uniform by id skips the name lookup.
+	struct UniformId {
+		int location = -1;
+	};
+
 	class Shader {
 	public:
 		Shader(const std::string& vertexShader, const std::string& fragmentShader);
 		void use()const;
+		inline unsigned int getID()const { return m_id; }
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
 		void setVec2(const std::string& name, float x, float y) const;
@@ -18,7 +27,25 @@ namespace ew {
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void setVec4(const std::string& name, const ew::Vec4& v) const;
 		void setMat4(const std::string& name, const ew::Mat4& m) const;
+
+		UniformId getUniformId(const std::string& name) const;
+		void setInt(UniformId id, int v) const;
+		void setFloat(UniformId id, float v) const;
+		void setVec2(UniformId id, const ew::Vec2& v) const;
+		void setVec3(UniformId id, const ew::Vec3& v) const;
+		void setVec4(UniformId id, const ew::Vec4& v) const;
+		void setMat4(UniformId id, const ew::Mat4& m) const;
+
+		//Connects a uniform block in this program to a UniformBuffer binding point
+		void bindUniformBlock(const std::string& blockName, unsigned int binding) const;
+
+		//Number of uniform name lookups since the last reset
+		inline unsigned int getLookupCount()const { return m_lookupCount; }
+		inline void resetLookupCount() { m_lookupCount = 0; }
 	private:
+		int getUniformLocation(const std::string& name) const;
 		unsigned int m_id; //Shader program handle
+		std::unordered_map<std::string, int> m_uniformLocations; //Active uniforms, reflected at link time
+		mutable unsigned int m_lookupCount = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "terrain.h"
+#include "procGen.h"
+#include "frustum.h"
+#include "threadPool.h"
+#include "external/stb_image.h"
+#include <stdio.h>
+#include <math.h>
+#include <mutex>
+#include <algorithm>
+
+namespace ew {
+	namespace {
+		//Rows per parallelFor range when displacing a patch
+		const size_t MIN_ROWS_PER_RANGE = 256;
+
+		inline uint32_t hashLattice(int x, int y, uint32_t seed) {
+			uint32_t h = seed + (uint32_t)x * 0x27D4EB2Du + (uint32_t)y * 0x165667B1u;
+			h ^= h >> 15;
+			h *= 0x85EBCA6Bu;
+			h ^= h >> 13;
+			h *= 0xC2B2AE35u;
+			h ^= h >> 16;
+			return h;
+		}
+		//Dot product of (dx, dy) with one of eight gradients picked by the lattice hash
+		inline float latticeGradient(int x, int y, uint32_t seed, float dx, float dy) {
+			switch (hashLattice(x, y, seed) & 7) {
+			case 0: return dx + dy;
+			case 1: return dx - dy;
+			case 2: return -dx + dy;
+			case 3: return -dx - dy;
+			case 4: return dx;
+			case 5: return -dx;
+			case 6: return dy;
+			default: return -dy;
+			}
+		}
+		inline float fade(float t) {
+			return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+		}
+		inline float lerp(float a, float b, float t) {
+			return a + (b - a) * t;
+		}
+		//Perlin style gradient noise, roughly within [-1, 1]
+		float gradientNoise(float x, float y, uint32_t seed) {
+			float fx = floorf(x), fy = floorf(y);
+			int ix = (int)fx, iy = (int)fy;
+			float dx = x - fx, dy = y - fy;
+			float u = fade(dx), v = fade(dy);
+			float a = latticeGradient(ix, iy, seed, dx, dy);
+			float b = latticeGradient(ix + 1, iy, seed, dx - 1.0f, dy);
+			float c = latticeGradient(ix, iy + 1, seed, dx, dy - 1.0f);
+			float d = latticeGradient(ix + 1, iy + 1, seed, dx - 1.0f, dy - 1.0f);
+			return lerp(lerp(a, b, u), lerp(c, d, u), v);
+		}
+
+		//Chunk grid coordinates and LOD packed into a map key
+		inline uint64_t makeChunkKey(int x, int z, int lod) {
+			return ((uint64_t)(uint32_t)x << 32) | ((uint64_t)(uint32_t)z << 8) | (uint64_t)lod;
+		}
+		inline int getChunkX(uint64_t key) { return (int)(key >> 32); }
+		inline int getChunkZ(uint64_t key) { return (int)((key >> 8) & 0xFFFFFF); }
+		inline int getChunkLod(uint64_t key) { return (int)(key & 0xFF); }
+	}
+
+	HeightFunction createNoiseHeight(float amplitude, float frequency, int octaves, unsigned int seed)
+	{
+		//Normalizes the octave sum so amplitude bounds the result
+		float total = 0.0f;
+		for (int i = 0; i < octaves; i++)
+			total += powf(0.5f, (float)i);
+		float scale = amplitude / total;
+		return [=](float x, float z) {
+			float sum = 0.0f;
+			float weight = 1.0f;
+			float f = frequency;
+			for (int i = 0; i < octaves; i++)
+			{
+				sum += gradientNoise(x * f, z * f, seed + i * 1013u) * weight;
+				weight *= 0.5f;
+				f *= 2.0f;
+			}
+			return sum * scale;
+		};
+	}
+	HeightFunction createHeightmapHeight(const char* filePath, float worldSize, float heightScale)
+	{
+		int width, height, numComponents;
+		unsigned short* data = stbi_load_16(filePath, &width, &height, &numComponents, 1);
+		if (data == NULL) {
+			printf("Failed to load heightmap %s\n", filePath);
+			return [](float, float) { return 0.0f; };
+		}
+		std::shared_ptr<std::vector<float>> heights = std::make_shared<std::vector<float>>((size_t)width * height);
+		for (size_t i = 0; i < heights->size(); i++)
+			(*heights)[i] = data[i] / 65535.0f * heightScale;
+		stbi_image_free(data);
+
+		//Bilinear, clamped at the edges
+		return [=](float x, float z) {
+			float u = ew::Clamp((x / worldSize + 0.5f) * (width - 1), 0.0f, (float)(width - 1));
+			float v = ew::Clamp((z / worldSize + 0.5f) * (height - 1), 0.0f, (float)(height - 1));
+			int x0 = std::min((int)u, width - 2 < 0 ? 0 : width - 2);
+			int y0 = std::min((int)v, height - 2 < 0 ? 0 : height - 2);
+			int x1 = std::min(x0 + 1, width - 1);
+			int y1 = std::min(y0 + 1, height - 1);
+			const float* h = heights->data();
+			float top = lerp(h[(size_t)y0 * width + x0], h[(size_t)y0 * width + x1], u - x0);
+			float bottom = lerp(h[(size_t)y1 * width + x0], h[(size_t)y1 * width + x1], u - x0);
+			return lerp(top, bottom, v - y0);
+		};
+	}
+
+	MeshData createTerrainPatch(const HeightFunction& height, float centerX, float centerZ, float size, int subdivisions,
+		float normalStep, float skirtDepth)
+	{
+		MeshData mesh = createPlane(size, size, subdivisions);
+
+		//Skirt along every edge used by a single triangle. Found from positions, since createPlane may have reordered the grid
+		float half = size * 0.5f;
+		float epsilon = size / subdivisions * 0.25f;
+		auto onBorder = [&](const ew::Vec3& a, const ew::Vec3& b) {
+			return (fabsf(fabsf(a.x) - half) < epsilon && fabsf(a.x - b.x) < epsilon) ||
+				(fabsf(fabsf(a.z) - half) < epsilon && fabsf(a.z - b.z) < epsilon);
+		};
+		size_t numGridVertices = mesh.vertices.size();
+		size_t numGridIndices = mesh.indices.size();
+		for (size_t i = 0; i < numGridIndices; i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int a = mesh.indices[i + e];
+				unsigned int b = mesh.indices[i + (e + 1) % 3];
+				unsigned int c = mesh.indices[i + (e + 2) % 3];
+				if (!onBorder(mesh.vertices[a].pos, mesh.vertices[b].pos))
+					continue;
+				unsigned int skirtA = (unsigned int)mesh.vertices.size();
+				unsigned int skirtB = skirtA + 1;
+				mesh.vertices.push_back(mesh.vertices[a]);
+				mesh.vertices.push_back(mesh.vertices[b]);
+				//Winding must face away from the triangle's third vertex. Seen from outside, a, b, b' is counter clockwise
+				//when the edge runs clockwise around the patch, which is the case when c is to the left of a->b from above
+				ew::Vec3 edge = mesh.vertices[b].pos - mesh.vertices[a].pos;
+				ew::Vec3 toC = mesh.vertices[c].pos - mesh.vertices[a].pos;
+				bool cOnLeft = edge.z * toC.x - edge.x * toC.z > 0.0f;
+				if (cOnLeft) {
+					unsigned int triangles[6] = { a, skirtB, b, a, skirtA, skirtB };
+					mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+				}
+				else {
+					unsigned int triangles[6] = { a, b, skirtB, a, skirtB, skirtA };
+					mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+				}
+			}
+		}
+
+		Vertex* vertices = mesh.vertices.data();
+		size_t numVertices = mesh.vertices.size();
+		getThreadPool().parallelFor(numVertices, MIN_ROWS_PER_RANGE, [=, &height](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				Vertex& v = vertices[i];
+				float x = centerX + v.pos.x;
+				float z = centerZ + v.pos.z;
+				float left = height(x - normalStep, z);
+				float right = height(x + normalStep, z);
+				float back = height(x, z - normalStep);
+				float front = height(x, z + normalStep);
+				v.normal = ew::Normalize(ew::Vec3(left - right, 2.0f * normalStep, back - front));
+				v.pos = ew::Vec3(x, height(x, z) - (i >= numGridVertices ? skirtDepth : 0.0f), z);
+			}
+		});
+		mesh.bounds = computeBounds(mesh.vertices);
+		return mesh;
+	}
+
+	struct Terrain::JobResults {
+		std::mutex mutex;
+		std::vector<std::pair<uint64_t, MeshData>> finished;
+		bool cancelled = false;
+	};
+
+	Terrain::Terrain(const HeightFunction& height, const TerrainSettings& settings)
+		:m_height(height), m_settings(settings), m_results(std::make_shared<JobResults>())
+	{
+	}
+	Terrain::~Terrain()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_results->mutex);
+			m_results->cancelled = true;
+		}
+		for (auto& chunk : m_chunks)
+			chunk.second.mesh.unload();
+	}
+	void Terrain::requestChunk(uint64_t key)
+	{
+		m_pending.insert(key);
+		int lod = getChunkLod(key);
+		float size = m_settings.chunkSize;
+		float centerX = -m_settings.worldSize * 0.5f + (getChunkX(key) + 0.5f) * size;
+		float centerZ = -m_settings.worldSize * 0.5f + (getChunkZ(key) + 0.5f) * size;
+		int subdivisions = std::max(m_settings.chunkSubdivisions >> lod, 1);
+		float normalStep = size / m_settings.chunkSubdivisions;
+		float skirtDepth = m_settings.skirtDepth;
+		HeightFunction height = m_height;
+		std::shared_ptr<JobResults> results = m_results;
+		auto job = [=]() {
+			{
+				std::lock_guard<std::mutex> lock(results->mutex);
+				if (results->cancelled)
+					return;
+			}
+			MeshData meshData = createTerrainPatch(height, centerX, centerZ, size, subdivisions, normalStep, skirtDepth);
+			std::lock_guard<std::mutex> lock(results->mutex);
+			results->finished.emplace_back(key, std::move(meshData));
+		};
+		//Without workers the chunk is built here, which is why requests are limited per update
+		ThreadPool& pool = getThreadPool();
+		if (pool.getNumThreads() == 0)
+			job();
+		else
+			pool.submit(job);
+	}
+	void Terrain::upload(uint64_t key, const MeshData& meshData)
+	{
+		Chunk& chunk = m_chunks[key];
+		chunk.mesh.load(meshData);
+		chunk.bytes = (size_t)chunk.mesh.getVertexSize() * chunk.mesh.getNumVertices() + (size_t)chunk.mesh.getIndexSize() * chunk.mesh.getNumIndices();
+		chunk.lastUsedFrame = m_frame;
+		m_memoryBytes += chunk.bytes;
+	}
+	void Terrain::evict()
+	{
+		if (m_memoryBytes <= m_settings.memoryBudget)
+			return;
+		std::vector<std::pair<uint64_t, uint64_t>> candidates;
+		for (const auto& chunk : m_chunks)
+		{
+			//Chunks drawn this frame are never evicted, even if that leaves the budget exceeded
+			if (chunk.second.lastUsedFrame != m_frame)
+				candidates.emplace_back(chunk.second.lastUsedFrame, chunk.first);
+		}
+		std::sort(candidates.begin(), candidates.end());
+		for (size_t i = 0; i < candidates.size() && m_memoryBytes > m_settings.memoryBudget; i++)
+		{
+			Chunk& chunk = m_chunks[candidates[i].second];
+			chunk.mesh.unload();
+			m_memoryBytes -= chunk.bytes;
+			m_chunks.erase(candidates[i].second);
+		}
+	}
+
+	void Terrain::update(const ew::Camera& camera)
+	{
+		m_frame++;
+		{
+			std::lock_guard<std::mutex> lock(m_results->mutex);
+			for (auto& result : m_results->finished)
+				m_ready.push_back(std::move(result));
+			m_results->finished.clear();
+		}
+
+		//Wanted chunks, nearest first
+		const TerrainSettings& s = m_settings;
+		int chunksPerSide = (int)(s.worldSize / s.chunkSize);
+		float origin = -s.worldSize * 0.5f;
+		float reach = s.viewDistance + s.chunkSize;
+		int minX = std::max((int)floorf((camera.position.x - reach - origin) / s.chunkSize), 0);
+		int maxX = std::min((int)floorf((camera.position.x + reach - origin) / s.chunkSize), chunksPerSide - 1);
+		int minZ = std::max((int)floorf((camera.position.z - reach - origin) / s.chunkSize), 0);
+		int maxZ = std::min((int)floorf((camera.position.z + reach - origin) / s.chunkSize), chunksPerSide - 1);
+		std::vector<std::pair<float, uint64_t>> wanted;
+		for (int z = minZ; z <= maxZ; z++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				//Distance to the nearest point of the chunk's square
+				float dx = std::max(fabsf(camera.position.x - (origin + (x + 0.5f) * s.chunkSize)) - s.chunkSize * 0.5f, 0.0f);
+				float dz = std::max(fabsf(camera.position.z - (origin + (z + 0.5f) * s.chunkSize)) - s.chunkSize * 0.5f, 0.0f);
+				float distance = sqrtf(dx * dx + dz * dz);
+				if (distance > s.viewDistance)
+					continue;
+				int lod = distance < s.lodDistance ? 0 : 1 + (int)floorf(log2f(distance / s.lodDistance));
+				lod = std::min(lod, s.numLods - 1);
+				wanted.emplace_back(distance, makeChunkKey(x, z, lod));
+			}
+		}
+		std::sort(wanted.begin(), wanted.end());
+		//Camera distance of every wanted chunk
+		std::unordered_map<uint64_t, float> wantedKeys;
+		for (const auto& w : wanted)
+			wantedKeys[w.second] = w.first;
+
+		//Uploads of chunks that are still wanted, nearest first, then the ones no longer wanted
+		auto uploadOrder = [&](uint64_t key) {
+			auto it = wantedKeys.find(key);
+			return it != wantedKeys.end() ? it->second : INFINITY;
+		};
+		std::sort(m_ready.begin(), m_ready.end(), [&](const std::pair<uint64_t, MeshData>& a, const std::pair<uint64_t, MeshData>& b) {
+			return uploadOrder(a.first) < uploadOrder(b.first);
+		});
+		int uploads = 0;
+		size_t consumed = 0;
+		for (; consumed < m_ready.size(); consumed++)
+		{
+			uint64_t key = m_ready[consumed].first;
+			if (wantedKeys.count(key) == 0) {
+				m_pending.erase(key);
+				continue;
+			}
+			if (uploads >= s.maxUploadsPerFrame)
+				break;
+			upload(key, m_ready[consumed].second);
+			m_pending.erase(key);
+			uploads++;
+		}
+		m_ready.erase(m_ready.begin(), m_ready.begin() + consumed);
+
+		//Draw each wanted chunk, or the nearest LOD of it that is resident while the wanted one is built
+		size_t maxPending = (size_t)(getThreadPool().getNumThreads() + 1) * 2;
+		int requests = 0;
+		m_drawList.clear();
+		for (const auto& w : wanted)
+		{
+			uint64_t key = w.second;
+			auto found = m_chunks.find(key);
+			if (found == m_chunks.end()) {
+				bool canRequest = getThreadPool().getNumThreads() > 0 ? m_pending.size() < maxPending : requests < s.maxUploadsPerFrame;
+				if (m_pending.count(key) == 0 && canRequest) {
+					requestChunk(key);
+					requests++;
+				}
+				int lod = getChunkLod(key);
+				for (int offset = 1; offset < s.numLods && found == m_chunks.end(); offset++)
+				{
+					if (lod + offset < s.numLods)
+						found = m_chunks.find(makeChunkKey(getChunkX(key), getChunkZ(key), lod + offset));
+					if (found == m_chunks.end() && lod - offset >= 0)
+						found = m_chunks.find(makeChunkKey(getChunkX(key), getChunkZ(key), lod - offset));
+				}
+				if (found == m_chunks.end())
+					continue;
+			}
+			found->second.lastUsedFrame = m_frame;
+			m_drawList.push_back(found->first);
+		}
+		//Synchronous builds finish inside requestChunk, so they are uploaded on the next update
+		evict();
+	}
+	void Terrain::draw(const ew::Camera& camera) const
+	{
+		Frustum frustum = extractFrustum(camera.ProjectionMatrix() * camera.ViewMatrix());
+		m_numDrawn = 0;
+		for (uint64_t key : m_drawList)
+		{
+			const Chunk& chunk = m_chunks.at(key);
+			if (!isVisible(frustum, chunk.mesh.getBounds()))
+				continue;
+			chunk.mesh.draw();
+			m_numDrawn++;
+		}
+	}
+}
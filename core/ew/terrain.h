@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+#include "mesh.h"
+#include "camera.h"
+
+namespace ew {
+	//World space height at (x, z). Called from worker threads, so it must be safe to call concurrently
+	typedef std::function<float(float x, float z)> HeightFunction;
+
+	//Fractal gradient noise, roughly within [-amplitude, amplitude]. frequency is in cycles per world unit
+	HeightFunction createNoiseHeight(float amplitude, float frequency, int octaves = 6, unsigned int seed = 1);
+	//Grayscale image stretched over a worldSize square centered on the origin, black at 0 and white at heightScale.
+	//16 bit images keep their precision. Returns a flat function if the image fails to load
+	HeightFunction createHeightmapHeight(const char* filePath, float worldSize, float heightScale);
+
+	/// <summary>
+	/// createPlane patch centered on (centerX, centerZ) in world space, displaced by height.
+	/// Normals are central differences of height with step normalStep, so patches of any subdivision that share
+	/// a normalStep light identically along their shared edges. A skirt hangs skirtDepth below every border edge
+	/// to hide cracks where neighbors use different subdivisions.
+	/// </summary>
+	MeshData createTerrainPatch(const HeightFunction& height, float centerX, float centerZ, float size, int subdivisions,
+		float normalStep, float skirtDepth);
+
+	struct TerrainSettings {
+		//Side of the square world, centered on the origin. 4096 is 16km^2 at a meter per unit
+		float worldSize = 4096.0f;
+		float chunkSize = 64.0f;
+		//Quads per chunk side at LOD 0. Each further LOD halves it
+		int chunkSubdivisions = 64;
+		int numLods = 4;
+		//Chunks closer than this use LOD 0. The distance doubles for every further LOD
+		float lodDistance = 128.0f;
+		float viewDistance = 1024.0f;
+		float skirtDepth = 4.0f;
+		//GPU bytes kept resident. Chunks unused for the longest are deleted first once it is exceeded
+		size_t memoryBudget = 128 * 1024 * 1024;
+		//Finished chunks uploaded per update, which bounds the GL work of a single frame
+		int maxUploadsPerFrame = 4;
+	};
+
+	/// <summary>
+	/// Streams createTerrainPatch chunks around a camera. update requests missing chunks from the thread pool,
+	/// uploads a few finished ones, and evicts the least recently used ones over the memory budget.
+	/// Until a chunk's wanted LOD arrives, any other resident LOD of it is drawn instead.
+	/// </summary>
+	class Terrain {
+	public:
+		Terrain(const HeightFunction& height, const TerrainSettings& settings = TerrainSettings());
+		~Terrain();
+		Terrain(const Terrain&) = delete;
+		Terrain& operator=(const Terrain&) = delete;
+
+		//Call once per frame before draw, on the thread that owns the GL context
+		void update(const ew::Camera& camera);
+		//Draws the chunks picked by the last update that are inside the camera frustum.
+		//Vertices are in world space, so the shader's model matrix should be identity
+		void draw(const ew::Camera& camera)const;
+		inline float getHeight(float x, float z)const { return m_height(x, z); }
+		inline const TerrainSettings& getSettings()const { return m_settings; }
+		inline size_t getNumResidentChunks()const { return m_chunks.size(); }
+		inline size_t getNumPendingChunks()const { return m_pending.size(); }
+		//Chunks drawn by the last draw call
+		inline size_t getNumDrawnChunks()const { return m_numDrawn; }
+		inline size_t getMemoryBytes()const { return m_memoryBytes; }
+	private:
+		struct Chunk {
+			Mesh mesh;
+			size_t bytes = 0;
+			uint64_t lastUsedFrame = 0;
+		};
+		//Finished MeshData handed back by workers. Shared so jobs that outlive the Terrain stay valid
+		struct JobResults;
+		void requestChunk(uint64_t key);
+		void upload(uint64_t key, const MeshData& meshData);
+		void evict();
+		HeightFunction m_height;
+		TerrainSettings m_settings;
+		std::unordered_map<uint64_t, Chunk> m_chunks;
+		std::unordered_set<uint64_t> m_pending;
+		std::shared_ptr<JobResults> m_results;
+		std::vector<std::pair<uint64_t, MeshData>> m_ready;
+		std::vector<uint64_t> m_drawList;
+		mutable size_t m_numDrawn = 0;
+		size_t m_memoryBytes = 0;
+		uint64_t m_frame = 0;
+	};
+}
@@ -0,0 +1,108 @@
+#include "threadPool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace ew {
+	ThreadPool::ThreadPool(unsigned int numThreads)
+	{
+		if (numThreads == 0) {
+			unsigned int hardware = std::thread::hardware_concurrency();
+			numThreads = hardware > 1 ? hardware - 1 : 1;
+		}
+		for (unsigned int i = 0; i < numThreads; i++)
+		{
+			m_threads.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_condition.notify_all();
+		for (size_t i = 0; i < m_threads.size(); i++)
+		{
+			m_threads[i].join();
+		}
+	}
+	void ThreadPool::submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+	void ThreadPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+				if (m_jobs.empty())
+					return;
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			job();
+		}
+	}
+	/// <summary>
+	/// Ranges are claimed through an atomic counter, so helpers that start late simply find nothing left.
+	/// The calling thread claims ranges too, which keeps nested calls from waiting on busy workers.
+	/// </summary>
+	void ThreadPool::parallelFor(size_t count, size_t minRange, const std::function<void(size_t begin, size_t end)>& fn)
+	{
+		if (count == 0)
+			return;
+		if (minRange == 0)
+			minRange = 1;
+		size_t maxRanges = (count + minRange - 1) / minRange;
+		//A few ranges per thread so uneven rows still balance
+		size_t numRanges = std::min(maxRanges, (size_t)(m_threads.size() + 1) * 4);
+		if (numRanges <= 1 || m_threads.empty()) {
+			fn(0, count);
+			return;
+		}
+		size_t rangeSize = (count + numRanges - 1) / numRanges;
+		numRanges = (count + rangeSize - 1) / rangeSize;
+
+		//Shared so helpers that outlive this call never touch freed memory
+		struct State {
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> done{ 0 };
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+		std::shared_ptr<State> state = std::make_shared<State>();
+		const std::function<void(size_t, size_t)>* body = &fn;
+		auto run = [state, body, count, rangeSize, numRanges]() {
+			size_t range;
+			while ((range = state->next.fetch_add(1)) < numRanges) {
+				size_t begin = range * rangeSize;
+				size_t end = std::min(begin + rangeSize, count);
+				(*body)(begin, end);
+				if (state->done.fetch_add(1) + 1 == numRanges) {
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->finished.notify_all();
+				}
+			}
+		};
+		size_t helpers = std::min(numRanges - 1, m_threads.size());
+		for (size_t i = 0; i < helpers; i++)
+		{
+			submit(run);
+		}
+		run();
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state, numRanges] { return state->done.load() == numRanges; });
+	}
+	ThreadPool& getThreadPool()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+}
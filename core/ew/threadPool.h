@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace ew {
+	/// <summary>
+	/// Fixed set of worker threads pulling jobs from a shared queue.
+	/// </summary>
+	class ThreadPool {
+	public:
+		//0 uses one worker per hardware thread, minus the calling thread
+		ThreadPool(unsigned int numThreads = 0);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		//Queues a job. It runs on a worker at some later point
+		void submit(std::function<void()> job);
+		//Splits [0, count) into ranges of at least minRange and runs fn on each, using the workers and the calling thread.
+		//Returns once every range is done. Safe to call from inside a job
+		void parallelFor(size_t count, size_t minRange, const std::function<void(size_t begin, size_t end)>& fn);
+		inline unsigned int getNumThreads()const { return (unsigned int)m_threads.size(); }
+	private:
+		void workerLoop();
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+	};
+
+	//Process wide pool, created on first use
+	ThreadPool& getThreadPool();
+}
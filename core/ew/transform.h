@@ -1,6 +1,7 @@
 #pragma once
 #include "ewMath/ewMath.h"
 #include "ewMath/transformations.h"
+#include "ewMath/quat.h"
 namespace ew {
 	struct Transform {
 		ew::Vec3 position = ew::Vec3(0.0f, 0.0f, 0.0f);
@@ -15,4 +16,52 @@ namespace ew {
 				* ew::Scale(scale);
 		}
 	};
+
+	/// <summary>
+	/// Transform that stores rotation as a quaternion and caches its model and normal matrices.
+	/// Matrices are only rebuilt after position, rotation or scale change through the setters.
+	/// </summary>
+	class CachedTransform {
+	public:
+		inline const ew::Vec3& getPosition()const { return m_position; }
+		inline const ew::Quat& getRotation()const { return m_rotation; }
+		inline const ew::Vec3& getScale()const { return m_scale; }
+		inline void setPosition(const ew::Vec3& position) { m_position = position; m_dirty = true; }
+		inline void setRotation(const ew::Quat& rotation) { m_rotation = rotation; m_dirty = true; }
+		//Euler angles (Degrees), same order as ew::Transform
+		inline void setRotation(const ew::Vec3& eulerDegrees) {
+			setRotation(ew::FromEuler(ew::Vec3(ew::Radians(eulerDegrees.x), ew::Radians(eulerDegrees.y), ew::Radians(eulerDegrees.z))));
+		}
+		inline void setScale(const ew::Vec3& scale) { m_scale = scale; m_dirty = true; }
+
+		inline const ew::Mat4& getModelMatrix()const {
+			if (m_dirty) recompute();
+			return m_model;
+		}
+		//Inverse transpose of the model matrix, for transforming normals
+		inline const ew::Mat4& getNormalMatrix()const {
+			if (m_dirty) recompute();
+			return m_normal;
+		}
+	private:
+		void recompute()const {
+			ew::Mat4 r = ew::ToMat4(m_rotation);
+			//Model = T * R * S. For an orthonormal R, inverse transpose of (R * S) is R * S^-1
+			const float s[3] = { m_scale.x, m_scale.y, m_scale.z };
+			m_model = r;
+			m_normal = r;
+			for (int i = 0; i < 3; i++) {
+				m_model[i] *= s[i];
+				m_normal[i] *= s[i] != 0.0f ? 1.0f / s[i] : 0.0f;
+			}
+			m_model[3] = ew::Vec4(m_position, 1.0f);
+			m_dirty = false;
+		}
+		ew::Vec3 m_position = ew::Vec3(0.0f, 0.0f, 0.0f);
+		ew::Quat m_rotation;
+		ew::Vec3 m_scale = ew::Vec3(1.0f, 1.0f, 1.0f);
+		mutable ew::Mat4 m_model;
+		mutable ew::Mat4 m_normal;
+		mutable bool m_dirty = true;
+	};
 }
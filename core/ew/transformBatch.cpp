@@ -0,0 +1,161 @@
+#include "transformBatch.h"
+#include "ewMath/simd.h"
+
+namespace ew {
+	namespace {
+		const size_t BLOCK_SIZE = 8;
+
+		using namespace ew::simd;
+
+		/// <summary>
+		/// Branch free sine. Reduces to [-PI, PI], folds to [-PI/2, PI/2] and evaluates a Taylor polynomial.
+		/// </summary>
+		inline FloatN sinN(FloatN x) {
+			x = subN(x, mulN(roundN(mulN(x, setN(1.0f / ew::TAU))), setN(ew::TAU)));
+			x = maxN(minN(x, subN(setN(ew::PI), x)), subN(setN(-ew::PI), x));
+			FloatN x2 = mulN(x, x);
+			FloatN p = setN(-1.0f / 39916800.0f);
+			p = addN(mulN(p, x2), setN(1.0f / 362880.0f));
+			p = addN(mulN(p, x2), setN(-1.0f / 5040.0f));
+			p = addN(mulN(p, x2), setN(1.0f / 120.0f));
+			p = addN(mulN(p, x2), setN(-1.0f / 6.0f));
+			p = addN(mulN(p, x2), setN(1.0f));
+			return mulN(p, x);
+		}
+		inline FloatN cosN(FloatN x) {
+			return sinN(addN(x, setN(ew::PI * 0.5f)));
+		}
+
+		/// <summary>
+		/// Stores a column of LANES matrices. Each row argument holds that row's value for every lane.
+		/// </summary>
+		inline void storeColumn(ew::Mat4* out, int col, FloatN r0, FloatN r1, FloatN r2, FloatN r3) {
+#if defined(EW_SIMD_AVX)
+			__m128 lo0 = _mm256_castps256_ps128(r0), lo1 = _mm256_castps256_ps128(r1);
+			__m128 lo2 = _mm256_castps256_ps128(r2), lo3 = _mm256_castps256_ps128(r3);
+			__m128 hi0 = _mm256_extractf128_ps(r0, 1), hi1 = _mm256_extractf128_ps(r1, 1);
+			__m128 hi2 = _mm256_extractf128_ps(r2, 1), hi3 = _mm256_extractf128_ps(r3, 1);
+			_MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+			_MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+			_mm_store_ps(&out[0][col].x, lo0);
+			_mm_store_ps(&out[1][col].x, lo1);
+			_mm_store_ps(&out[2][col].x, lo2);
+			_mm_store_ps(&out[3][col].x, lo3);
+			_mm_store_ps(&out[4][col].x, hi0);
+			_mm_store_ps(&out[5][col].x, hi1);
+			_mm_store_ps(&out[6][col].x, hi2);
+			_mm_store_ps(&out[7][col].x, hi3);
+#elif defined(EW_SIMD_SSE)
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(&out[0][col].x, r0);
+			_mm_store_ps(&out[1][col].x, r1);
+			_mm_store_ps(&out[2][col].x, r2);
+			_mm_store_ps(&out[3][col].x, r3);
+#else
+			out[0][col] = ew::Vec4(r0, r1, r2, r3);
+#endif
+		}
+	}
+
+	TransformBatch::TransformBatch(size_t count)
+	{
+		resize(count);
+	}
+	void TransformBatch::resize(size_t count)
+	{
+		size_t padded = (count + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+		positionX.resize(padded, 0.0f); positionY.resize(padded, 0.0f); positionZ.resize(padded, 0.0f);
+		rotationX.resize(padded, 0.0f); rotationY.resize(padded, 0.0f); rotationZ.resize(padded, 0.0f);
+		scaleX.resize(padded, 1.0f); scaleY.resize(padded, 1.0f); scaleZ.resize(padded, 1.0f);
+		m_count = count;
+	}
+	void TransformBatch::setTransform(size_t i, const ew::Transform& transform)
+	{
+		setPosition(i, transform.position);
+		setRotation(i, transform.rotation);
+		setScale(i, transform.scale);
+	}
+	ew::Transform TransformBatch::getTransform(size_t i) const
+	{
+		ew::Transform transform;
+		transform.position = getPosition(i);
+		transform.rotation = getRotation(i);
+		transform.scale = getScale(i);
+		return transform;
+	}
+	void TransformBatch::setPosition(size_t i, const ew::Vec3& position)
+	{
+		positionX[i] = position.x; positionY[i] = position.y; positionZ[i] = position.z;
+	}
+	void TransformBatch::setRotation(size_t i, const ew::Vec3& rotation)
+	{
+		rotationX[i] = rotation.x; rotationY[i] = rotation.y; rotationZ[i] = rotation.z;
+	}
+	void TransformBatch::setScale(size_t i, const ew::Vec3& scale)
+	{
+		scaleX[i] = scale.x; scaleY[i] = scale.y; scaleZ[i] = scale.z;
+	}
+	ew::Vec3 TransformBatch::getPosition(size_t i) const
+	{
+		return ew::Vec3(positionX[i], positionY[i], positionZ[i]);
+	}
+	ew::Vec3 TransformBatch::getRotation(size_t i) const
+	{
+		return ew::Vec3(rotationX[i], rotationY[i], rotationZ[i]);
+	}
+	ew::Vec3 TransformBatch::getScale(size_t i) const
+	{
+		return ew::Vec3(scaleX[i], scaleY[i], scaleZ[i]);
+	}
+	/// <summary>
+	/// Closed form of Translate(p) * RotateY(y) * RotateX(x) * RotateZ(z) * Scale(s)
+	/// </summary>
+	/// <param name="out">Array of at least size() matrices</param>
+	void TransformBatch::computeModelMatrices(ew::Mat4* out) const
+	{
+		ew::Mat4 tail[BLOCK_SIZE];
+		for (size_t block = 0; block < m_count; block += BLOCK_SIZE)
+		{
+			//Partial last block is written to a scratch array
+			bool partial = block + BLOCK_SIZE > m_count;
+			ew::Mat4* dst = partial ? tail : out + block;
+			for (size_t lane = 0; lane < BLOCK_SIZE; lane += LANES)
+			{
+				size_t i = block + lane;
+				const FloatN deg2Rad = setN(ew::DEG2RAD);
+				FloatN rx = mulN(loadN(&rotationX[i]), deg2Rad);
+				FloatN ry = mulN(loadN(&rotationY[i]), deg2Rad);
+				FloatN rz = mulN(loadN(&rotationZ[i]), deg2Rad);
+				FloatN sinX = sinN(rx), cosX = cosN(rx);
+				FloatN sinY = sinN(ry), cosY = cosN(ry);
+				FloatN sinZ = sinN(rz), cosZ = cosN(rz);
+				FloatN sx = loadN(&scaleX[i]), sy = loadN(&scaleY[i]), sz = loadN(&scaleZ[i]);
+
+				FloatN sinXsinZ = mulN(sinX, sinZ);
+				FloatN sinXcosZ = mulN(sinX, cosZ);
+				//Rotation matrix entries, (row)(col)
+				FloatN r00 = addN(mulN(cosY, cosZ), mulN(sinY, sinXsinZ));
+				FloatN r01 = subN(mulN(sinY, sinXcosZ), mulN(cosY, sinZ));
+				FloatN r02 = mulN(sinY, cosX);
+				FloatN r10 = mulN(cosX, sinZ);
+				FloatN r11 = mulN(cosX, cosZ);
+				FloatN r12 = subN(setN(0.0f), sinX);
+				FloatN r20 = subN(mulN(cosY, sinXsinZ), mulN(sinY, cosZ));
+				FloatN r21 = addN(mulN(sinY, sinZ), mulN(cosY, sinXcosZ));
+				FloatN r22 = mulN(cosY, cosX);
+
+				const FloatN zero = setN(0.0f);
+				storeColumn(dst + lane, 0, mulN(r00, sx), mulN(r10, sx), mulN(r20, sx), zero);
+				storeColumn(dst + lane, 1, mulN(r01, sy), mulN(r11, sy), mulN(r21, sy), zero);
+				storeColumn(dst + lane, 2, mulN(r02, sz), mulN(r12, sz), mulN(r22, sz), zero);
+				storeColumn(dst + lane, 3, loadN(&positionX[i]), loadN(&positionY[i]), loadN(&positionZ[i]), setN(1.0f));
+			}
+			if (partial) {
+				for (size_t i = block; i < m_count; i++)
+				{
+					out[i] = tail[i - block];
+				}
+			}
+		}
+	}
+}
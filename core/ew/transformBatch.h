@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+#include "transform.h"
+
+namespace ew {
+	/// <summary>
+	/// Structure of arrays container for many transforms.
+	/// Same conventions as ew::Transform (T * Ry * Rx * Rz * S, Euler angles in degrees),
+	/// but all model matrices are built in one call, 8 objects at a time.
+	/// </summary>
+	class TransformBatch {
+	public:
+		TransformBatch() {};
+		TransformBatch(size_t count);
+		void resize(size_t count);
+		inline size_t size()const { return m_count; }
+
+		void setTransform(size_t i, const ew::Transform& transform);
+		ew::Transform getTransform(size_t i)const;
+		void setPosition(size_t i, const ew::Vec3& position);
+		void setRotation(size_t i, const ew::Vec3& rotation);
+		void setScale(size_t i, const ew::Vec3& scale);
+		ew::Vec3 getPosition(size_t i)const;
+		ew::Vec3 getRotation(size_t i)const;
+		ew::Vec3 getScale(size_t i)const;
+
+		//Writes size() model matrices to out
+		void computeModelMatrices(ew::Mat4* out)const;
+
+		//Each array is padded to a multiple of 8 entries
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ; //Euler angles (Degrees)
+		std::vector<float> scaleX, scaleY, scaleZ;
+	private:
+		size_t m_count = 0;
+	};
+}
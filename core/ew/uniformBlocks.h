@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	//Binding points shared by every program that declares the matching block
+	enum UniformBlockBinding {
+		FRAME_BLOCK_BINDING = 0,
+		LIGHT_BLOCK_BINDING = 1,
+		MATERIAL_BLOCK_BINDING = 2,
+		CLUSTER_BLOCK_BINDING = 3
+	};
+
+	/// <summary>
+	/// layout(std140) uniform FrameData {
+	///		mat4 _ViewProjection;
+	///		vec3 _CameraPosition;
+	/// };
+	/// </summary>
+	struct FrameData {
+		ew::Mat4 viewProjection;
+		ew::Vec3 cameraPosition;
+		float pad0;
+	};
+
+	/// <summary>
+	/// struct Light { vec3 position; vec3 color; };
+	/// layout(std140) uniform LightData {
+	///		Light _Lights[MAX_LIGHTS];
+	///		int _LightsAmount;
+	/// };
+	/// </summary>
+	struct LightData {
+		static const int MAX_LIGHTS = 4;
+		struct Light {
+			ew::Vec3 position;
+			float pad0;
+			ew::Vec3 color;
+			float pad1;
+		};
+		Light lights[MAX_LIGHTS];
+		int count;
+		int pad0[3];
+	};
+
+	/// <summary>
+	/// layout(std140) uniform MaterialData {
+	///		float _Ambient;
+	///		float _Diffuse;
+	///		float _Specular;
+	///		float _Shininess;
+	/// };
+	/// </summary>
+	struct MaterialData {
+		float ambientK;
+		float diffuseK;
+		float specular;
+		float shininess;
+	};
+
+	/// <summary>
+	/// Everything a fragment needs to find its light cluster (see clusteredLights.h):
+	/// layout(std140) uniform ClusterData {
+	///		mat4 _View;
+	///		ivec4 _ClusterCounts;
+	///		vec2 _ScreenSize;
+	///		float _ClusterDepthScale;
+	///		float _ClusterDepthBias;
+	/// };
+	/// The depth slice of a fragment at view depth d is floor(log(d) * _ClusterDepthScale - _ClusterDepthBias)
+	/// </summary>
+	struct ClusterData {
+		ew::Mat4 view;
+		int clusterCounts[4]; //x, y, z, unused
+		ew::Vec2 screenSize;
+		float depthScale;
+		float depthBias;
+	};
+
+	//std140: vec3 and structs align to 16 bytes, block sizes round up to 16 bytes
+	static_assert(offsetof(FrameData, viewProjection) == 0, "FrameData layout does not match std140");
+	static_assert(offsetof(FrameData, cameraPosition) == 64, "FrameData layout does not match std140");
+	static_assert(sizeof(FrameData) == 80, "FrameData layout does not match std140");
+	static_assert(offsetof(LightData::Light, color) == 16, "LightData layout does not match std140");
+	static_assert(sizeof(LightData::Light) == 32, "LightData layout does not match std140");
+	static_assert(offsetof(LightData, count) == 32 * LightData::MAX_LIGHTS, "LightData layout does not match std140");
+	static_assert(sizeof(LightData) % 16 == 0, "LightData layout does not match std140");
+	static_assert(sizeof(MaterialData) == 16, "MaterialData layout does not match std140");
+	static_assert(offsetof(ClusterData, clusterCounts) == 64, "ClusterData layout does not match std140");
+	static_assert(offsetof(ClusterData, screenSize) == 80, "ClusterData layout does not match std140");
+	static_assert(sizeof(ClusterData) == 96, "ClusterData layout does not match std140");
+}
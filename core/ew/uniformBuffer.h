@@ -0,0 +1,37 @@
+#pragma once
+#include "external/glad.h"
+
+namespace ew {
+	/// <summary>
+	/// Owns a uniform buffer object sized for T and attached to a fixed binding point.
+	/// T must mirror the std140 layout of the GLSL block it feeds (see uniformBlocks.h).
+	/// </summary>
+	template<typename T>
+	class UniformBuffer {
+	public:
+		UniformBuffer(unsigned int binding) :m_binding(binding) {
+			glGenBuffers(1, &m_ubo);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ubo);
+		}
+		~UniformBuffer() {
+			glDeleteBuffers(1, &m_ubo);
+		}
+		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+		//Uploads the whole block with a single glBufferSubData
+		void update(const T& data)const {
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+		inline unsigned int getBinding()const { return m_binding; }
+		inline unsigned int getHandle()const { return m_ubo; }
+	private:
+		unsigned int m_ubo = 0;
+		unsigned int m_binding = 0;
+	};
+}
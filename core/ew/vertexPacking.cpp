@@ -0,0 +1,168 @@
+#include "vertexPacking.h"
+#include "ewMath/simd.h"
+#include "ewMath/transformations.h"
+#include "external/glad.h"
+#include <string.h>
+#include <math.h>
+
+namespace ew {
+	namespace {
+		inline int16_t packSnorm16(float value) {
+			return (int16_t)lrintf(fminf(fmaxf(value, -1.0f), 1.0f) * 32767.0f);
+		}
+		inline uint32_t packSnorm10(float value) {
+			return (uint32_t)lrintf(fminf(fmaxf(value, -1.0f), 1.0f) * 511.0f) & 0x3FF;
+		}
+		inline void packVertex(const Vertex& v, const ew::Vec3& center, const ew::Vec3& invExtent, PackedVertex* out) {
+			out->pos[0] = packSnorm16((v.pos.x - center.x) * invExtent.x);
+			out->pos[1] = packSnorm16((v.pos.y - center.y) * invExtent.y);
+			out->pos[2] = packSnorm16((v.pos.z - center.z) * invExtent.z);
+			out->pos[3] = 0;
+			out->normal = packSnorm10(v.normal.x) | (packSnorm10(v.normal.y) << 10) | (packSnorm10(v.normal.z) << 20);
+			out->uv[0] = floatToHalf(v.uv.x);
+			out->uv[1] = floatToHalf(v.uv.y);
+		}
+		//Center and half size of the box, with zero sized axes left at zero instead of dividing by zero
+		inline void getQuantizeRange(const Bounds& bounds, ew::Vec3* center, ew::Vec3* extent, ew::Vec3* invExtent) {
+			*center = (bounds.min + bounds.max) * 0.5f;
+			*extent = (bounds.max - bounds.min) * 0.5f;
+			*invExtent = ew::Vec3(
+				extent->x > 0.0f ? 1.0f / extent->x : 0.0f,
+				extent->y > 0.0f ? 1.0f / extent->y : 0.0f,
+				extent->z > 0.0f ? 1.0f / extent->z : 0.0f);
+		}
+	}
+	static_assert(sizeof(Vertex) == 32, "packVertices loads ew::Vertex as two groups of 4 floats");
+
+	/// <summary>
+	/// Round to nearest even. Out of range values become infinity, tiny values become subnormals or zero.
+	/// </summary>
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t exponent = (bits >> 23) & 0xFF;
+		uint32_t mantissa = bits & 0x7FFFFF;
+		if (exponent == 0xFF)
+			return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+		int halfExponent = (int)exponent - 127 + 15;
+		if (halfExponent >= 31)
+			return (uint16_t)(sign | 0x7C00);
+		if (halfExponent <= 0) {
+			if (halfExponent < -10)
+				return (uint16_t)sign;
+			mantissa |= 0x800000;
+			int shift = 14 - halfExponent;
+			uint32_t half = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1)))
+				half++;
+			return (uint16_t)(sign | half);
+		}
+		uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+		uint32_t remainder = mantissa & 0x1FFF;
+		//A carry out of the mantissa correctly bumps the exponent
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+			half++;
+		return (uint16_t)(sign | half);
+	}
+	float halfToFloat(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+		if (exponent == 0) {
+			float subnormal = ldexpf((float)mantissa, -24);
+			return sign ? -subnormal : subnormal;
+		}
+		uint32_t bits = exponent == 31
+			? sign | 0x7F800000 | (mantissa << 13)
+			: sign | ((exponent + 112) << 23) | (mantissa << 13);
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+	ew::Mat4 getDequantizeMatrix(const Bounds& bounds)
+	{
+		ew::Vec3 center, extent, invExtent;
+		getQuantizeRange(bounds, &center, &extent, &invExtent);
+		return ew::Translate(center) * ew::Scale(extent);
+	}
+	/// <summary>
+	/// Four vertices per iteration: two 4x4 transposes turn them into position, normal and uv lanes,
+	/// which are quantized together and transposed back into PackedVertex order.
+	/// </summary>
+	void packVertices(const std::vector<Vertex>& vertices, const Bounds& bounds, std::vector<PackedVertex>* out)
+	{
+		ew::Vec3 center, extent, invExtent;
+		getQuantizeRange(bounds, &center, &extent, &invExtent);
+		out->resize(vertices.size());
+		PackedVertex* dst = out->data();
+		size_t i = 0;
+#if defined(EW_SIMD_SSE)
+		const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f);
+		const __m128 snorm16 = _mm_set1_ps(32767.0f), snorm10 = _mm_set1_ps(511.0f);
+		const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+		const __m128 ix = _mm_set1_ps(invExtent.x), iy = _mm_set1_ps(invExtent.y), iz = _mm_set1_ps(invExtent.z);
+		const __m128i mask16 = _mm_set1_epi32(0xFFFF), mask10 = _mm_set1_epi32(0x3FF);
+		for (; i + 4 <= vertices.size(); i += 4)
+		{
+			const float* src = &vertices[i].pos.x;
+			//Rows are vertices before the transpose, attributes after it
+			__m128 px = _mm_loadu_ps(src), py = _mm_loadu_ps(src + 8), pz = _mm_loadu_ps(src + 16), nx = _mm_loadu_ps(src + 24);
+			__m128 ny = _mm_loadu_ps(src + 4), nz = _mm_loadu_ps(src + 12), u = _mm_loadu_ps(src + 20), v = _mm_loadu_ps(src + 28);
+			_MM_TRANSPOSE4_PS(px, py, pz, nx);
+			_MM_TRANSPOSE4_PS(ny, nz, u, v);
+
+			#define EW_CLAMP_SNORM(x) _mm_min_ps(_mm_max_ps(x, minusOne), one)
+			__m128i qx = _mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(_mm_mul_ps(_mm_sub_ps(px, cx), ix)), snorm16));
+			__m128i qy = _mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(_mm_mul_ps(_mm_sub_ps(py, cy), iy)), snorm16));
+			__m128i qz = _mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(_mm_mul_ps(_mm_sub_ps(pz, cz), iz)), snorm16));
+			__m128i qnx = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(nx), snorm10)), mask10);
+			__m128i qny = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(ny), snorm10)), mask10);
+			__m128i qnz = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(EW_CLAMP_SNORM(nz), snorm10)), mask10);
+			#undef EW_CLAMP_SNORM
+
+			__m128i word0 = _mm_or_si128(_mm_and_si128(qx, mask16), _mm_slli_epi32(qy, 16));
+			__m128i word1 = _mm_and_si128(qz, mask16);
+			__m128i word2 = _mm_or_si128(qnx, _mm_or_si128(_mm_slli_epi32(qny, 10), _mm_slli_epi32(qnz, 20)));
+#if defined(EW_SIMD_F16C)
+			__m128i word3 = _mm_unpacklo_epi16(_mm_cvtps_ph(u, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+#else
+			float us[4], vs[4];
+			_mm_storeu_ps(us, u);
+			_mm_storeu_ps(vs, v);
+			__m128i word3 = _mm_setr_epi32(
+				floatToHalf(us[0]) | (floatToHalf(vs[0]) << 16), floatToHalf(us[1]) | (floatToHalf(vs[1]) << 16),
+				floatToHalf(us[2]) | (floatToHalf(vs[2]) << 16), floatToHalf(us[3]) | (floatToHalf(vs[3]) << 16));
+#endif
+			__m128 r0 = _mm_castsi128_ps(word0), r1 = _mm_castsi128_ps(word1), r2 = _mm_castsi128_ps(word2), r3 = _mm_castsi128_ps(word3);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps((float*)(dst + i), r0);
+			_mm_storeu_ps((float*)(dst + i + 1), r1);
+			_mm_storeu_ps((float*)(dst + i + 2), r2);
+			_mm_storeu_ps((float*)(dst + i + 3), r3);
+		}
+#endif
+		for (; i < vertices.size(); i++)
+		{
+			packVertex(vertices[i], center, invExtent, dst + i);
+		}
+	}
+	void setPackedVertexAttributes()
+	{
+		//Position attribute, signed normalized
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, pos));
+		glEnableVertexAttribArray(0);
+
+		//Normal attribute. 10_10_10_2 formats must be read with 4 components, the shader ignores w
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, normal));
+		glEnableVertexAttribArray(1);
+
+		//UV attribute
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, uv));
+		glEnableVertexAttribArray(2);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "mesh.h"
+
+namespace ew {
+	/// <summary>
+	/// 16 byte vertex, half the size of ew::Vertex.
+	/// Positions are signed normalized against the mesh bounds (see getDequantizeMatrix),
+	/// normals are GL_INT_2_10_10_10_REV and UVs are half floats, so shaders read the same vec3/vec3/vec2 inputs.
+	/// </summary>
+	struct PackedVertex {
+		int16_t pos[4]; //xyz, w unused
+		uint32_t normal;
+		uint16_t uv[2];
+	};
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+	uint16_t floatToHalf(float value);
+	float halfToFloat(uint16_t value);
+
+	//Maps the [-1, 1] packed position range back onto the bounds. Multiply it into the model matrix
+	ew::Mat4 getDequantizeMatrix(const Bounds& bounds);
+	//Quantizes every vertex. bounds must contain all vertex positions
+	void packVertices(const std::vector<Vertex>& vertices, const Bounds& bounds, std::vector<PackedVertex>* out);
+	//Sets up the ew::PackedVertex attribute layout for the bound VAO and GL_ARRAY_BUFFER
+	void setPackedVertexAttributes();
+}